@@ -0,0 +1,101 @@
+#include "StdAfx.h"
+#include "ChainAnalyzer.h"
+
+#include <CryRenderer/IRenderAuxGeom.h>
+
+namespace
+{
+	// Link check for a falling piece of a given kind, its dimensions fold into constants
+	template<typename TTraits>
+	bool FindBreak(const Vec3& forward, const Vec3& nextForward, const Vec3& delta, float minTurnCos, CChainAnalyzer::EBreak& reason)
+	{
+		// The top edge sweeps out to about the height in front of the pivot, on the far face
+		constexpr float reach = TTraits::Height + TTraits::Thickness * .5f;
+
+		// A piece topples the same way whichever of its faces points down the stroke, so only the axis counts
+		const float along = fabs_tpl(delta.x * forward.x + delta.y * forward.y);
+		const float across = fabs_tpl(delta.x * forward.y - delta.y * forward.x);
+
+		if (along <= 0.f || along - TTraits::Thickness * .5f > reach)
+			reason = CChainAnalyzer::EBreak::TooFar;
+		else if (across > TTraits::Width)
+			reason = CChainAnalyzer::EBreak::OffPath;
+		else if (fabs_tpl(forward.Dot(nextForward)) < minTurnCos)
+			reason = CChainAnalyzer::EBreak::TooTight;
+		else
+			return false;
+
+		return true;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CChainAnalyzer::AnalyzeStroke(const CDominoWorldPartition& dominoes, const std::vector<CDominoWorldPartition::DominoId>& stroke)
+{
+	const CDominoWorldPartition::SDominoRecord* pPrevious = nullptr;
+	CDominoWorldPartition::DominoId previousId = CDominoWorldPartition::InvalidId;
+
+	for (CDominoWorldPartition::DominoId id : stroke)
+	{
+		const CDominoWorldPartition::SDominoRecord& record = dominoes.GetRecord(id);
+		if (dominoes.IsHidden(id) || record.isRemoved)
+			continue;
+
+		if (pPrevious != nullptr)
+		{
+			// Dominoes face along their Y axis and topple forwards
+			Vec3 forward = pPrevious->restRotation.GetColumn1();
+			forward.z = 0;
+			forward.NormalizeSafe(Vec3(0, 1, 0));
+
+			Vec3 nextForward = record.restRotation.GetColumn1();
+			nextForward.z = 0;
+			nextForward.NormalizeSafe(Vec3(0, 1, 0));
+
+			const Vec3 delta = record.restPosition - pPrevious->restPosition;
+
+			// The falling piece's kind decides the reach, so mixed kinds chain correctly
+			EBreak reason;
+			const bool isBroken = DispatchDominoKind(pPrevious->kind, [&](auto traits)
+				{
+					return FindBreak<decltype(traits)>(forward, nextForward, delta, m_minTurnCos, reason);
+				});
+
+			if (isBroken)
+				m_breaks.push_back({ previousId, id, reason });
+		}
+
+		pPrevious = &record;
+		previousId = id;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CChainAnalyzer::Draw(const CDominoWorldPartition& dominoes) const
+{
+	if (m_breaks.empty())
+		return;
+
+	m_lines.clear();
+	m_lines.reserve(m_breaks.size() * 6);
+
+	for (const SBreak& chainBreak : m_breaks)
+	{
+		const CDominoWorldPartition::SDominoRecord& fromRecord = dominoes.GetRecord(chainBreak.from);
+		const Vec3& from = fromRecord.restPosition;
+		const Vec3& to = dominoes.GetRecord(chainBreak.to).restPosition;
+		const Vec3 lift(0, 0, CDominoKindRegistry::Get(fromRecord.kind).height);
+
+		// A bridge over the gap plus a post on each side
+		m_lines.push_back(from + lift);
+		m_lines.push_back(to + lift);
+		m_lines.push_back(from);
+		m_lines.push_back(from + lift);
+		m_lines.push_back(to);
+		m_lines.push_back(to + lift);
+	}
+
+	gEnv->pAuxGeomRenderer->GetAux()->DrawLines(m_lines.data(), (uint32)m_lines.size(), Col_Red, 3.f);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "DominoWorldPartition.h"
+
+////////////////////////////////////////////////////////
+// Geometric topple-reach check over placed strokes
+// Flags every link where a falling domino can't reach the next one,
+// without running the physics
+////////////////////////////////////////////////////////
+
+class CChainAnalyzer
+{
+public:
+	enum class EBreak : uint8
+	{
+		// The next piece is further away than the falling piece can reach
+		TooFar = 0,
+		// The next piece is off to the side of the falling piece's path
+		OffPath,
+		// The turn between two pieces is too tight for the push to carry over
+		TooTight
+	};
+
+	struct SBreak
+	{
+		CDominoWorldPartition::DominoId from;
+		CDominoWorldPartition::DominoId to;
+		EBreak reason;
+	};
+
+	// Checks consecutive pieces of one stroke, in placement order
+	void AnalyzeStroke(const CDominoWorldPartition& dominoes, const std::vector<CDominoWorldPartition::DominoId>& stroke);
+	void Clear() { m_breaks.clear(); }
+
+	const std::vector<SBreak>& GetBreaks() const { return m_breaks; }
+
+	// All breaks in a single aux-geom line batch
+	void Draw(const CDominoWorldPartition& dominoes) const;
+
+	// Cosine of the sharpest turn that still topples the next piece
+	float m_minTurnCos = .7f;
+
+private:
+	std::vector<SBreak> m_breaks;
+	mutable std::vector<Vec3> m_lines;
+};
@@ -0,0 +1,308 @@
+#include "StdAfx.h"
+#include "ChainTelemetry.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "DebugDraw.h"
+
+namespace
+{
+	typedef std::unordered_map<uint64, std::vector<CChainTelemetry::DominoId>> TGrid;
+
+	uint64 GetGridKey(const Vec3& position, float gridSize)
+	{
+		const int32 x = (int32)floor_tpl(position.x / gridSize);
+		const int32 y = (int32)floor_tpl(position.y / gridSize);
+		return ((uint64)(uint32)x << 32) | (uint64)(uint32)y;
+	}
+
+	// Calls func for every piece of the grid in the 3x3 cells around position
+	template<typename TFunc>
+	void ForEachNear(const TGrid& grid, float gridSize, const Vec3& position, TFunc&& func)
+	{
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				auto it = grid.find(GetGridKey(position + Vec3(dx * gridSize, dy * gridSize, 0), gridSize));
+				if (it == grid.end())
+					continue;
+
+				for (CChainTelemetry::DominoId id : it->second)
+				{
+					func(id);
+				}
+			}
+		}
+	}
+
+	bool WriteFile(const char* path, const string& text)
+	{
+		FILE* pFile = gEnv->pCryPak->FOpen(path, "wt");
+		if (pFile == nullptr)
+			return false;
+
+		const size_t written = gEnv->pCryPak->FWrite(text.c_str(), 1, text.length(), pFile);
+		gEnv->pCryPak->FClose(pFile);
+		return written == text.length();
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CChainTelemetry::Begin(const CDominoWorldPartition& partition)
+{
+	m_timings.assign(partition.GetIdCount(), STiming());
+	m_summary = SSummary();
+	m_time = 0.f;
+	m_contactCursor = CDominoCollisions::Get().GetCursor();
+	m_isRecording = true;
+}
+
+//----------------------------------------------------------------------------------
+
+void CChainTelemetry::Update(const CDominoWorldPartition& partition, float frameTime)
+{
+	if (!m_isRecording)
+		return;
+
+	m_time += frameTime;
+
+	// Every piece is woken when the run starts, a piece only really wakes when something hits it
+	m_contacted.clear();
+	CDominoCollisions::Get().Consume(m_contactCursor, [this](const CDominoCollisions::SContact& contact)
+		{
+			for (size_t i = 0; i < 2; i++)
+			{
+				if (contact.dominoMask & (1 << i))
+					m_contacted.push_back(contact.entityIds[i]);
+			}
+		});
+	std::sort(m_contacted.begin(), m_contacted.end());
+
+	partition.ForEachMaterialized([this, &partition](DominoId id, IEntity& entity)
+		{
+			IPhysicalEntity* pPhysics = entity.GetPhysics();
+			if (pPhysics == nullptr || id >= m_timings.size())
+				return;
+
+			STiming& timing = m_timings[id];
+			if (timing.settle != STiming::Unset)
+				return;
+
+			if (timing.wake == STiming::Unset && std::binary_search(m_contacted.begin(), m_contacted.end(), entity.GetId()))
+				timing.wake = m_time;
+
+			pe_status_awake status;
+			const bool isAwake = pPhysics->GetStatus(&status) != 0;
+
+			if (timing.topple == STiming::Unset)
+			{
+				// Past the angle where the centre of mass leaves the base, the piece can only fall
+				const CDominoWorldPartition::SDominoRecord& record = partition.GetRecord(id);
+				const SDominoKindDesc& kind = CDominoKindRegistry::Get(record.kind);
+				const float tippingCos = kind.height / sqrt_tpl(sqr(kind.height) + sqr(kind.thickness));
+
+				if (entity.GetWorldRotation().GetColumn2().Dot(record.restRotation.GetColumn2()) < tippingCos)
+				{
+					timing.topple = m_time;
+					// A piece that falls before anything touches it started the chain itself
+					if (timing.wake == STiming::Unset)
+						timing.wake = m_time;
+				}
+			}
+			else if (!isAwake)
+			{
+				timing.settle = m_time;
+			}
+		});
+}
+
+//----------------------------------------------------------------------------------
+
+void CChainTelemetry::End(const CDominoWorldPartition& partition)
+{
+	if (!m_isRecording)
+		return;
+
+	m_isRecording = false;
+	m_summary = SSummary();
+	m_summary.duration = m_time;
+
+	std::vector<DominoId> toppled;
+	for (DominoId id = 0; id < (DominoId)m_timings.size(); id++)
+	{
+		if (m_timings[id].topple != STiming::Unset)
+			toppled.push_back(id);
+	}
+
+	std::sort(toppled.begin(), toppled.end(), [this](DominoId a, DominoId b)
+		{
+			return m_timings[a].topple < m_timings[b].topple;
+		});
+
+	m_summary.toppledCount = toppled.size();
+	if (toppled.empty())
+		return;
+
+	float gridSize = 0.f;
+	for (size_t kind = 0; kind < (size_t)EDominoKind::Count; kind++)
+	{
+		gridSize = max(gridSize, CDominoKindRegistry::Get((EDominoKind)kind).reach);
+	}
+
+	// Each toppled piece was pushed by the nearest piece that had toppled before it and reaches it
+	TGrid grid;
+	float speedSum = 0.f;
+	size_t speedCount = 0;
+	m_summary.minWaveSpeed = FLT_MAX;
+
+	for (DominoId id : toppled)
+	{
+		const Vec3& position = partition.GetRecord(id).restPosition;
+
+		DominoId pusher = CDominoWorldPartition::InvalidId;
+		float pusherDistance = FLT_MAX;
+		ForEachNear(grid, gridSize, position, [&](DominoId other)
+			{
+				const CDominoWorldPartition::SDominoRecord& record = partition.GetRecord(other);
+				const float distance = record.restPosition.GetDistance(position);
+				if (distance <= CDominoKindRegistry::Get(record.kind).reach && distance < pusherDistance)
+				{
+					pusher = other;
+					pusherDistance = distance;
+				}
+			});
+
+		if (pusher != CDominoWorldPartition::InvalidId)
+		{
+			const float linkTime = m_timings[id].topple - m_timings[pusher].topple;
+			if (linkTime > m_stallTime)
+				m_summary.stallCount++;
+
+			if (linkTime > 0.f)
+			{
+				const float speed = pusherDistance / linkTime;
+				speedSum += speed;
+				speedCount++;
+				m_summary.minWaveSpeed = min(m_summary.minWaveSpeed, speed);
+				m_summary.maxWaveSpeed = max(m_summary.maxWaveSpeed, speed);
+			}
+		}
+
+		grid[GetGridKey(position, gridSize)].push_back(id);
+	}
+
+	if (speedCount > 0)
+		m_summary.meanWaveSpeed = speedSum / (float)speedCount;
+	else
+		m_summary.minWaveSpeed = 0.f;
+
+	// A standing piece within reach of a toppled one is where a chain broke
+	for (DominoId id = 0; id < (DominoId)m_timings.size(); id++)
+	{
+		const CDominoWorldPartition::SDominoRecord& record = partition.GetRecord(id);
+		if (m_timings[id].topple != STiming::Unset || record.isRemoved || partition.IsHidden(id))
+			continue;
+
+		bool isReached = false;
+		ForEachNear(grid, gridSize, record.restPosition, [&](DominoId other)
+			{
+				const CDominoWorldPartition::SDominoRecord& pusher = partition.GetRecord(other);
+				isReached |= pusher.restPosition.GetDistance(record.restPosition) <= CDominoKindRegistry::Get(pusher.kind).reach;
+			});
+
+		if (isReached)
+			m_summary.breakCount++;
+	}
+
+	// Equal slices of the whole run, as Draw labels them
+	for (DominoId id : toppled)
+	{
+		const size_t bucket = m_summary.duration > 0.f ? (size_t)(m_timings[id].topple / m_summary.duration * HistogramBuckets) : 0;
+		m_summary.histogram[min(bucket, HistogramBuckets - 1)]++;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool CChainTelemetry::ExportCsv(const CDominoWorldPartition& partition, const char* path) const
+{
+	string text = "id,kind,x,y,z,wake,topple,settle\n";
+	for (DominoId id = 0; id < (DominoId)m_timings.size(); id++)
+	{
+		const CDominoWorldPartition::SDominoRecord& record = partition.GetRecord(id);
+		if (record.isRemoved)
+			continue;
+
+		const STiming& timing = m_timings[id];
+		text += string().Format("%u,%s,%.3f,%.3f,%.3f,%.4f,%.4f,%.4f\n", id, CDominoKindRegistry::Get(record.kind).name,
+			record.restPosition.x, record.restPosition.y, record.restPosition.z, timing.wake, timing.topple, timing.settle);
+	}
+
+	return WriteFile(path, text);
+}
+
+//----------------------------------------------------------------------------------
+
+bool CChainTelemetry::ExportJson(const char* path) const
+{
+	string histogram;
+	for (size_t i = 0; i < HistogramBuckets; i++)
+	{
+		histogram += string().Format(i == 0 ? "%u" : ", %u", m_summary.histogram[i]);
+	}
+
+	const string text = string().Format(
+		"{\n"
+		"\t\"dominoes\": %u,\n"
+		"\t\"toppled\": %u,\n"
+		"\t\"breaks\": %u,\n"
+		"\t\"stalls\": %u,\n"
+		"\t\"duration\": %.4f,\n"
+		"\t\"waveSpeed\": { \"mean\": %.4f, \"min\": %.4f, \"max\": %.4f },\n"
+		"\t\"toppleHistogram\": [%s]\n"
+		"}\n",
+		(uint32)m_timings.size(), (uint32)m_summary.toppledCount, (uint32)m_summary.breakCount, (uint32)m_summary.stallCount,
+		m_summary.duration, m_summary.meanWaveSpeed, m_summary.minWaveSpeed, m_summary.maxWaveSpeed, histogram.c_str());
+
+	return WriteFile(path, text);
+}
+
+//----------------------------------------------------------------------------------
+
+void CChainTelemetry::Draw() const
+{
+#if DOMINO_DEBUG_DRAW
+	if (!CDebugDraw::IsEnabled(CDebugDraw::ELevel::Basic) || m_isRecording || m_summary.toppledCount == 0)
+		return;
+
+	const float x = 10.f;
+	float y = 60.f;
+	const string header = string().Format("Run %.2f s toppled %u breaks %u stalls %u wave m/s avg %.2f min %.2f max %.2f",
+		m_summary.duration, (uint32)m_summary.toppledCount, (uint32)m_summary.breakCount, (uint32)m_summary.stallCount,
+		m_summary.meanWaveSpeed, m_summary.minWaveSpeed, m_summary.maxWaveSpeed);
+	DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Basic, x, y, Col_Cyan, header.c_str());
+
+	const uint32 peak = *std::max_element(m_summary.histogram.begin(), m_summary.histogram.end());
+	const float bucketTime = m_summary.duration / (float)HistogramBuckets;
+	for (size_t i = 0; i < HistogramBuckets; i++)
+	{
+		// Text bars, 40 columns at the busiest slice
+		const uint32 count = m_summary.histogram[i];
+		char bar[41] = {};
+		memset(bar, '#', peak > 0 ? count * 40 / peak : 0);
+		const string row = string().Format("%5.2f s %-40s %u", bucketTime * i, bar, count);
+		DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Basic, x, y += 12.f, Col_Cyan, row.c_str());
+	}
+#endif
+}
+
+//----------------------------------------------------------------------------------
+
+void CChainTelemetry::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddContainer(m_timings);
+	pSizer->AddContainer(m_contacted);
+}
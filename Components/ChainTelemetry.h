@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "DominoCollisions.h"
+#include "DominoWorldPartition.h"
+
+////////////////////////////////////////////////////////
+// Timeline of one simulation run
+// Records when each domino was first hit, tipped past its balance point and came to
+// rest, in one compact array indexed by domino id. Wave speed, stalls and breaks are
+// derived from it when the run ends, see d_dominoTelemetry
+////////////////////////////////////////////////////////
+
+class CChainTelemetry
+{
+public:
+	typedef CDominoWorldPartition::DominoId DominoId;
+	static constexpr size_t HistogramBuckets = 16;
+
+	// Seconds since the run started, Unset until the event happened
+	struct STiming
+	{
+		static constexpr float Unset = -1.f;
+
+		float wake = Unset;
+		float topple = Unset;
+		float settle = Unset;
+	};
+
+	struct SSummary
+	{
+		size_t toppledCount = 0;
+		// Pieces a toppled neighbour could reach that still stood at the end
+		size_t breakCount = 0;
+		// Links where the next piece took longer than m_stallTime to tip
+		size_t stallCount = 0;
+		float duration = 0.f;
+		// Metres per second along the links between consecutive toppled pieces
+		float meanWaveSpeed = 0.f;
+		float minWaveSpeed = 0.f;
+		float maxWaveSpeed = 0.f;
+		// Toppled pieces per slice of the run
+		std::array<uint32, HistogramBuckets> histogram = {};
+	};
+
+	void Begin(const CDominoWorldPartition& partition);
+	// Samples the materialized pieces, O(materialized)
+	void Update(const CDominoWorldPartition& partition, float frameTime);
+	// Derives the summary from the recorded timings
+	void End(const CDominoWorldPartition& partition);
+
+	bool IsRecording() const { return m_isRecording; }
+	bool HasRun() const { return !m_timings.empty(); }
+	const STiming& GetTiming(DominoId id) const { return m_timings[id]; }
+	const SSummary& GetSummary() const { return m_summary; }
+
+	// Per-domino timings as CSV and the summary as JSON, both through ICryPak
+	bool ExportCsv(const CDominoWorldPartition& partition, const char* path) const;
+	bool ExportJson(const char* path) const;
+
+	// Summary and topple histogram as debug labels
+	void Draw() const;
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+	// A link slower than this counts as a stall
+	float m_stallTime = .5f;
+
+private:
+	std::vector<STiming> m_timings;
+	SSummary m_summary;
+	float m_time = 0.f;
+	bool m_isRecording = false;
+
+	CDominoCollisions::Cursor m_contactCursor = 0;
+	// Domino entities in this frame's contacts, sorted
+	std::vector<EntityId> m_contacted;
+};
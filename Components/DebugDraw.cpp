@@ -0,0 +1,102 @@
+#include "StdAfx.h"
+#include "DebugDraw.h"
+
+#include <CryRenderer/IRenderAuxGeom.h>
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------
+
+void CDebugDraw::AddPoint(const Vec3& position, const ColorB& color)
+{
+	m_points.push_back({ position, color });
+}
+
+//----------------------------------------------------------------------------------
+
+void CDebugDraw::AddLine(const Vec3& from, const Vec3& to, const ColorB& color)
+{
+	m_linePoints.push_back(from);
+	m_linePoints.push_back(to);
+	m_lineColors.push_back(color);
+	m_lineColors.push_back(color);
+}
+
+//----------------------------------------------------------------------------------
+
+void CDebugDraw::AddAABB(const AABB& box, const ColorB& color)
+{
+	AddOBB(OBB::CreateOBBfromAABB(Matrix33(IDENTITY), box), Vec3(ZERO), color);
+}
+
+//----------------------------------------------------------------------------------
+
+void CDebugDraw::AddOBB(const OBB& box, const Vec3& center, const ColorB& color)
+{
+	// Corner i takes the +h side on axis k when bit k of i is set
+	Vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		const Vec3 local((i & 1) ? box.h.x : -box.h.x, (i & 2) ? box.h.y : -box.h.y, (i & 4) ? box.h.z : -box.h.z);
+		corners[i] = center + box.m33 * (box.c + local);
+	}
+
+	// Each edge joins two corners that differ in a single bit
+	for (int i = 0; i < 8; i++)
+	{
+		for (int bit = 1; bit < 8; bit <<= 1)
+		{
+			if ((i & bit) == 0)
+				AddLine(corners[i], corners[i | bit], color);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDebugDraw::AddLabel(float x, float y, const ColorF& color, const char* text)
+{
+	m_labels.push_back({ Vec2(x, y), color, text });
+}
+
+//----------------------------------------------------------------------------------
+
+void CDebugDraw::Flush()
+{
+	if (m_points.empty() && m_linePoints.empty() && m_labels.empty())
+		return;
+
+	IRenderAuxGeom* g = gEnv->pAuxGeomRenderer->GetAux();
+
+	// Points are grouped by colour so each group is a single call
+	std::sort(m_points.begin(), m_points.end(), [](const SPoint& a, const SPoint& b) { return a.color.pack_argb8888() < b.color.pack_argb8888(); });
+	for (size_t begin = 0; begin < m_points.size();)
+	{
+		const ColorB color = m_points[begin].color;
+
+		m_batch.clear();
+		size_t end = begin;
+		for (; end < m_points.size() && m_points[end].color == color; end++)
+		{
+			m_batch.push_back(m_points[end].position);
+		}
+
+		g->DrawPoints(m_batch.data(), (uint32)m_batch.size(), color, 8);
+		begin = end;
+	}
+
+	if (!m_linePoints.empty())
+	{
+		g->DrawLines(m_linePoints.data(), (uint32)m_linePoints.size(), m_lineColors.data(), 2.f);
+	}
+
+	for (const SLabel& label : m_labels)
+	{
+		g->Draw2dLabel(label.position.x, label.position.y, 1.5f, label.color, false, "%s", label.text.c_str());
+	}
+
+	m_points.clear();
+	m_linePoints.clear();
+	m_lineColors.clear();
+	m_labels.clear();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+
+#include "DominoCVars.h"
+
+////////////////////////////////////////////////////////
+// Frame-batched debug drawing gated by d_dominoDebugDraw
+// Primitives are collected during the frame and submitted once in Flush,
+// release builds compile every gated call site away. Gameplay overlays such as
+// the selection box go through the same batch without a level
+////////////////////////////////////////////////////////
+
+#if !defined(_RELEASE)
+	#define DOMINO_DEBUG_DRAW 1
+#else
+	#define DOMINO_DEBUG_DRAW 0
+#endif
+
+class CDebugDraw
+{
+public:
+	enum class ELevel : int
+	{
+		Off = 0,
+		// Cursor and other always useful markers
+		Basic,
+		// Internal placement state, per spawn labels
+		Verbose
+	};
+
+	static CDebugDraw& Get()
+	{
+		static CDebugDraw instance;
+		return instance;
+	}
+
+	static bool IsEnabled(ELevel level) { return SDominoCVars::Get().d_dominoDebugDraw >= (int)level; }
+
+	void AddPoint(const Vec3& position, const ColorB& color);
+	void AddLine(const Vec3& from, const Vec3& to, const ColorB& color);
+	// Wireframe boxes, added as their 12 edges to the line batch
+	void AddAABB(const AABB& box, const ColorB& color);
+	void AddOBB(const OBB& box, const Vec3& center, const ColorB& color);
+	void AddLabel(float x, float y, const ColorF& color, const char* text);
+
+	// Submits everything collected this frame, call once per frame
+	void Flush();
+
+private:
+	struct SPoint
+	{
+		Vec3 position;
+		ColorB color;
+	};
+
+	struct SLabel
+	{
+		Vec2 position;
+		ColorF color;
+		string text;
+	};
+
+	// Reused every frame, only grows
+	std::vector<SPoint> m_points;
+	std::vector<Vec3> m_linePoints;
+	std::vector<ColorB> m_lineColors;
+	std::vector<SLabel> m_labels;
+
+	std::vector<Vec3> m_batch;
+};
+
+#if DOMINO_DEBUG_DRAW
+	#define DOMINO_DEBUG_POINT(level, position, color) \
+		do { if (CDebugDraw::IsEnabled(level)) CDebugDraw::Get().AddPoint(position, color); } while (false)
+	#define DOMINO_DEBUG_LINE(level, from, to, color) \
+		do { if (CDebugDraw::IsEnabled(level)) CDebugDraw::Get().AddLine(from, to, color); } while (false)
+	#define DOMINO_DEBUG_LABEL(level, x, y, color, text) \
+		do { if (CDebugDraw::IsEnabled(level)) CDebugDraw::Get().AddLabel(x, y, color, text); } while (false)
+#else
+	#define DOMINO_DEBUG_POINT(level, position, color) ((void)0)
+	#define DOMINO_DEBUG_LINE(level, from, to, color) ((void)0)
+	#define DOMINO_DEBUG_LABEL(level, x, y, color, text) ((void)0)
+#endif
+
+// Not compiled away, the batch also carries the gameplay overlays
+#define DOMINO_DEBUG_FLUSH() CDebugDraw::Get().Flush()
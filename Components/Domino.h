@@ -12,12 +12,38 @@
 
 #include "CryRenderer/ITexture.h"
 #include "CryMath/Random.h"
+
+#include <array>
+
+#include "DominoCVars.h"
+#include "DominoKind.h"
+#include "DominoPhysics.h"
+#include "DebugDraw.h"
 //#include "CryRenderer/IShader.h"
 //#include "CryRenderer/IShader_info.h"
 
 class CDominoComponent final : public IEntityComponent
 {
 public:
+	enum class ELod : uint8
+	{
+		// Body and all pips
+		Full = 0,
+		// Body only
+		NoPips,
+		// Body only, at its low-poly LOD
+		Low,
+
+		Count
+	};
+
+	// Kind and pips a piece is created with, the pose and scale come from the spawn params
+	struct SSpawnDesc
+	{
+		EDominoKind kind;
+		std::array<uint8, 4> pips;
+	};
+
 	virtual ~CDominoComponent() {}
 
 	// IEntityComponent
@@ -25,47 +51,92 @@ public:
 	{
 		// Set the model
 		const int geometrySlot = 0;
-		GetEntity()->LoadGeometry(geometrySlot, "Objects/Dominoes.cgf");
+		GetEntity()->LoadGeometry(geometrySlot, DominoAssets::BodyGeometry);
 		
-		GetEntity()->LoadGeometry(geometrySlot +1, "Objects/Domino/1.cgf");
-		GetEntity()->LoadGeometry(geometrySlot +2, "Objects/Domino/2.cgf");
-		GetEntity()->LoadGeometry(geometrySlot + 3, "Objects/Domino/3.cgf");
-		GetEntity()->LoadGeometry(geometrySlot + 4, "Objects/Domino/4.cgf");
+		for (int i = 0; i < 4; i++) {
+			GetEntity()->LoadGeometry(geometrySlot + 1 + i, DominoAssets::PipGeometry[i]);
+		}
 
-		auto *pDominoMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial("Objects/dominoes1");
+		auto *pDominoMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial(DominoAssets::BodyMaterial);
 		m_pEntity->SetMaterial(pDominoMaterial);
 		
-		for (int i = 1; i < 5; i++) {
-			int r = cry_random(1, 6);
-			string name("materials/domino/" + ToString(r));
-			auto* pNumMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial(name);
-			
-			IRenderAuxGeom* g = gEnv->pAuxGeomRenderer->GetAux();
-			g->Draw2dLabel(10,10,3,Col_Yellow,false, name);
+		// Make sure that bullets are always rendered regardless of distance
+		// Ratio is 0 - 255, 255 being 100% visibility
+		GetEntity()->SetViewDistRatio(255);
+		GetEntity()->SetLodRatio(50);
 
-			m_pEntity->SetSlotMaterial(geometrySlot + i, pNumMaterial);
-		}
-		
-		
-		
-		
-		
+		// Spawned at a rest pose the partition already dropped onto the terrain
+		m_position = GetEntity()->GetWorldPos();
+		m_rotation = GetEntity()->GetWorldRotation();
+	}
+
+	// Gives a freshly created piece its kind and pips and physicalizes it, once, right after CreateComponentClass
+	// Initialize leaves both to this so nothing is applied twice
+	void Init(const SSpawnDesc& desc)
+	{
+		m_kind = desc.kind;
+		m_pips = desc.pips;
+		ApplyPips();
 
 		// Now create the physical representation of the entity
-		SEntityPhysicalizeParams physParams;
-		physParams.type = PE_RIGID;
-		physParams.mass = 1.f;
-		m_pEntity->Physicalize(physParams);
+		Physicalize();
+	}
 
+	// Physicalizes the piece with the constants of its kind, asleep
+	// The physical entity is created bare, the slot meshes are never physicalized, only the box is added
+	void Physicalize()
+	{
+		const SDominoKindDesc& kind = CDominoKindRegistry::Get(m_kind);
+
+		SEntityPhysicalizeParams noPhysics;
+		noPhysics.type = PE_NONE;
+		m_pEntity->Physicalize(noPhysics);
+
+		pe_params_pos pos;
+		pos.pos = GetEntity()->GetWorldPos();
+		pos.q = GetEntity()->GetWorldRotation();
+		IPhysicalEntity* pPhysics = gEnv->pPhysicalWorld->CreatePhysicalEntity(PE_RIGID, &pos, m_pEntity, PHYS_FOREIGN_ID_ENTITY);
+		if (pPhysics == nullptr)
+			return;
+
+		m_pEntity->AssignPhysicalEntity(pPhysics);
+		DominoPhysics::Tag(pPhysics);
+
+		// Added parts don't follow the entity scale, so the box takes the kind's size
+		// and is centred on the body mesh's bounds, wherever its pivot is
+		Vec3 center(0, 0, kind.height * .5f);
+		if (IStatObj* pBody = GetEntity()->GetStatObj(0))
+			center = pBody->GetAABB().GetCenter() * kind.scale;
+
+		DominoPhysics::AddBoxProxy(pPhysics, Vec3(kind.width, kind.thickness, kind.height), center, kind.mass);
+		DominoPhysics::ApplyProfile(pPhysics, kind.mass);
+
+		// Contacts are logged to the physics world, CDominoComponent itself never hears of them
+		pe_params_flags flags;
+		flags.flagsOR = pef_log_collisions;
+		pPhysics->SetParams(&flags);
 
-		// Make sure that bullets are always rendered regardless of distance
-		// Ratio is 0 - 255, 255 being 100% visibility
-		GetEntity()->SetViewDistRatio(255);
-		GetEntity()->SetLodRatio(50);
 		pe_action_awake awake; 
 		awake.bAwake = 0;
-		GetEntity()->GetPhysics()->Action(&awake);
+		pPhysics->Action(&awake);
+	}
+
+	// Rescales and re-physicalizes the piece if its kind changes
+	void SetKind(EDominoKind kind)
+	{
+		if (kind == m_kind)
+			return;
 
+		m_kind = kind;
+		GetEntity()->SetScale(Vec3(CDominoKindRegistry::Get(kind).scale));
+		Physicalize();
+	}
+
+	EDominoKind GetKind() const { return m_kind; }
+
+	// Drops the domino onto the terrain below it and stores the result as its rest pose
+	void SnapToTerrain()
+	{
 		const unsigned int rayFlags = rwi_stop_at_pierceable | rwi_colltype_any;
 		ray_hit hit;
 
@@ -76,30 +147,87 @@ public:
 
 		m_position = GetEntity()->GetWorldPos();
 		m_rotation = GetEntity()->GetWorldRotation();
+	}
+	Vec3 m_position = Vec3(0);
+	Quat m_rotation = IDENTITY;
+	std::array<uint8, 4> m_pips = {{ 1, 1, 1, 1 }};
+	ELod m_lod = ELod::Full;
+	EDominoKind m_kind = EDominoKind::Standard;
+
+	// Sets the pip materials of slots 1-4 from m_pips
+	void ApplyPips()
+	{
+		const int geometrySlot = 0;
+		for (int i = 1; i < 5; i++) {
+			string name(DominoAssets::PipMaterialPrefix + ToString(m_pips[i - 1]));
+			auto* pNumMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial(name);
+			
+			DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Verbose, 10, 10, Col_Yellow, name.c_str());
+
+			m_pEntity->SetSlotMaterial(geometrySlot + i, pNumMaterial);
+		}
+	}
 
+	// Switches pip rendering and body detail, cheap to call every frame
+	void SetLod(ELod lod)
+	{
+		if (lod == m_lod)
+			return;
 
+		const bool showPips = lod == ELod::Full;
+		if (showPips != (m_lod == ELod::Full))
+		{
+			for (int slot = 1; slot < 5; slot++)
+			{
+				const uint32 flags = GetEntity()->GetSlotFlags(slot);
+				GetEntity()->SetSlotFlags(slot, showPips ? (flags | ENTITY_SLOT_RENDER) : (flags & ~ENTITY_SLOT_RENDER));
+			}
+		}
 
+		if (lod == ELod::Low)
+		{
+			GetEntity()->SetLodRatio(SDominoCVars::Get().d_dominoLowLodRatio);
+			GetEntity()->SetViewDistRatio(SDominoCVars::Get().d_dominoLowViewDistRatio);
+		}
+		else if (m_lod == ELod::Low)
+		{
+			GetEntity()->SetViewDistRatio(255);
+			GetEntity()->SetLodRatio(50);
+		}
+
+		m_lod = lod;
 	}
-	Vec3 m_position = Vec3(0);
-	Quat m_rotation = IDENTITY;
+
+	ELod GetLod() const { return m_lod; }
+
+	// Moves an already initialized (e.g. pooled) domino to a new rest pose, asleep
+	void Place(const Vec3& position, const Quat& rotation)
+	{
+		m_position = position;
+		m_rotation = rotation;
+		GetEntity()->SetPosRotScale(m_position, m_rotation, Vec3(CDominoKindRegistry::Get(m_kind).scale));
+
+		if (IPhysicalEntity* pPhysics = GetEntity()->GetPhysics())
+		{
+			pe_action_awake awake;
+			awake.bAwake = 0;
+			pPhysics->Action(&awake);
+		}
+	}
+
 	// Reflect type to set a unique identifier for this component
 	static void ReflectType(Schematyc::CTypeDesc<CDominoComponent>& desc)
 	{
 		desc.SetGUID("{B53A9A5F-F27A-42CB-82C7-B1E379C41A2A}"_cry_guid);
 	}
 
-	virtual Cry::Entity::EventFlags GetEventMask() const override { return ENTITY_EVENT_COLLISION; }
-	virtual void ProcessEvent(const SEntityEvent& event) override
-	{
-		// Handle the OnCollision event, in order to have the entity removed on collision
-		if (event.event == ENTITY_EVENT_COLLISION)
-		{
-			// Collision info can be retrieved using the event pointer
-			//EventPhysCollision *physCollision = reinterpret_cast<EventPhysCollision *>(event.ptr);
+	// No entity events, contacts are gathered once for all pieces by CDominoCollisions
+	virtual Cry::Entity::EventFlags GetEventMask() const override { return Cry::Entity::EventFlags(); }
 
-			// Queue removal of this entity, unless it has already been done
-			//gEnv->pEntitySystem->RemoveEntity(GetEntityId());
-		}
+	virtual void GetMemoryUsage(ICrySizer* pSizer) const override
+	{
+		// No heap allocations, slots and physics are accounted by the entity
+		pSizer->AddObject(this, sizeof(*this));
 	}
 	// ~IEntityComponent
 
@@ -0,0 +1,143 @@
+#include "StdAfx.h"
+#include "DominoAssetPrefetch.h"
+
+#include <Cry3DEngine/I3DEngine.h>
+
+//----------------------------------------------------------------------------------
+
+void CDominoAssetPrefetch::Start()
+{
+	if (m_state != EState::Idle)
+		return;
+
+	// Same assets CDominoComponent and the chunk baker load
+	std::vector<const char*> geometries;
+	geometries.push_back(DominoAssets::BodyGeometry);
+	for (const char* szPipGeometry : DominoAssets::PipGeometry)
+	{
+		geometries.push_back(szPipGeometry);
+	}
+
+	m_materialRequests.clear();
+	m_materialRequests.push_back({ DominoAssets::BodyMaterial });
+	for (int i = 0; i < DominoAssets::PipValueCount; i++)
+	{
+		m_materialRequests.push_back({ DominoAssets::PipMaterialPrefix + ToString(i + 1) });
+	}
+
+	m_requestCount = geometries.size() + m_materialRequests.size();
+	m_completedCount = 0;
+	m_generation++;
+	m_state = EState::Loading;
+
+	// The callbacks arrive on the main thread once the mesh has streamed in
+	const uint32 generation = m_generation;
+	for (const char* szGeometry : geometries)
+	{
+		gEnv->p3DEngine->LoadStatObjAsync([this, generation](IStatObj* pGeometry)
+			{
+				if (generation != m_generation)
+					return;
+
+				if (pGeometry != nullptr)
+					m_geometries.push_back(pGeometry);
+				m_completedCount++;
+			}, szGeometry, nullptr, true);
+	}
+
+	StreamReadParams params;
+	params.ePriority = estpBelowNormal;
+	for (size_t i = 0; i < m_materialRequests.size(); i++)
+	{
+		params.dwUserData = (DWORD_PTR)i;
+		m_materialRequests[i].pStream = gEnv->pSystem->GetStreamEngine()->StartRead(eStreamTaskTypeReadAhead,
+			(m_materialRequests[i].name + ".mtl").c_str(), this, &params);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAssetPrefetch::StreamAsyncOnComplete(IReadStream* pStream, unsigned nError)
+{
+	// Stream thread, each request only touches its own slot
+	if (nError != 0 || pStream->GetBytesRead() == 0)
+		return;
+
+	SMaterial& material = m_materialRequests[(size_t)pStream->GetUserData()];
+	material.xml = gEnv->pSystem->LoadXmlFromBuffer((const char*)pStream->GetBuffer(), pStream->GetBytesRead());
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAssetPrefetch::StreamOnComplete(IReadStream* pStream, unsigned nError)
+{
+	// Reset is tearing the requests down
+	if (nError == ERROR_USER_ABORT)
+		return;
+
+	SMaterial& material = m_materialRequests[(size_t)pStream->GetUserData()];
+
+	if (material.xml != nullptr)
+	{
+		if (IMaterial* pMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterialFromXml(material.name, material.xml))
+		{
+			// Textures stream in the background
+			pMaterial->RequestTexturesLoading(0.f);
+			m_materials.push_back(pMaterial);
+		}
+	}
+	else
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "DominoAssetPrefetch: Couldn't stream %s.mtl (error %u)", material.name.c_str(), nError);
+	}
+
+	material.pStream = nullptr;
+	material.xml = nullptr;
+	m_completedCount++;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAssetPrefetch::Update()
+{
+	if (m_state == EState::Loading && m_completedCount >= m_requestCount)
+	{
+		CryLog("DominoAssetPrefetch: Ready, %d meshes and %d materials", (int)m_geometries.size(), (int)m_materials.size());
+		m_state = EState::Ready;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAssetPrefetch::Reset()
+{
+	// Aborted requests complete with ERROR_USER_ABORT and leave their slot alone
+	for (SMaterial& material : m_materialRequests)
+	{
+		if (material.pStream != nullptr)
+			material.pStream->Abort();
+	}
+	m_materialRequests.clear();
+
+	// Meshes still streaming finish on their own, their callbacks are ignored
+	m_generation++;
+
+	m_geometries.clear();
+	m_materials.clear();
+	m_requestCount = 0;
+	m_completedCount = 0;
+	m_state = EState::Idle;
+}
+
+//----------------------------------------------------------------------------------
+
+float CDominoAssetPrefetch::GetProgress() const
+{
+	if (m_state == EState::Ready)
+		return 1.f;
+
+	if (m_requestCount == 0)
+		return 0.f;
+
+	return (float)m_completedCount / (float)m_requestCount;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <CrySystem/IStreamEngine.h>
+#include <Cry3DEngine/IStatObj.h>
+
+#include "DominoKind.h"
+
+////////////////////////////////////////////////////////
+// Streams every domino asset in before the first piece needs it
+// Meshes go through the 3D engine's async stat object loading, material files are
+// read and parsed by the stream engine and only built from the parsed XML on the
+// main thread. Nothing waits for the prefetch, a piece placed early loads what is
+// still missing itself
+////////////////////////////////////////////////////////
+
+class CDominoAssetPrefetch : public IStreamCallback
+{
+public:
+	enum class EState
+	{
+		Idle = 0,
+		// Requests are in flight with the engine
+		Loading,
+		Ready
+	};
+
+	// Starts the prefetch unless it is already running or done
+	void Start();
+	// Main thread, once per frame, does nothing once ready
+	void Update();
+	// Aborts what is still streaming and drops the asset references
+	void Reset();
+
+	EState GetState() const { return m_state; }
+	bool IsReady() const { return m_state == EState::Ready; }
+	// 0 - 1, finished requests over all requests
+	float GetProgress() const;
+
+	static CDominoAssetPrefetch& Get()
+	{
+		static CDominoAssetPrefetch instance;
+		return instance;
+	}
+
+private:
+	struct SMaterial
+	{
+		string name;
+		IReadStreamPtr pStream;
+		// Parsed on the stream thread, built into a material on the main thread
+		XmlNodeRef xml;
+	};
+
+	// IStreamCallback
+	virtual void StreamAsyncOnComplete(IReadStream* pStream, unsigned nError) override;
+	virtual void StreamOnComplete(IReadStream* pStream, unsigned nError) override;
+	// ~IStreamCallback
+
+	std::vector<SMaterial> m_materialRequests;
+	size_t m_requestCount = 0;
+	size_t m_completedCount = 0;
+	// Stat object callbacks of an earlier Start are dropped
+	uint32 m_generation = 0;
+	EState m_state = EState::Idle;
+
+	std::vector<_smart_ptr<IStatObj>> m_geometries;
+	std::vector<_smart_ptr<IMaterial>> m_materials;
+};
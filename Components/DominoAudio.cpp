@@ -0,0 +1,232 @@
+#include "StdAfx.h"
+#include "DominoAudio.h"
+
+#include <algorithm>
+
+#include "DominoCVars.h"
+
+namespace
+{
+	// One trigger per layer, all three are one-shots authored in the audio middleware
+	const CryAudio::ControlId LayerTriggers[] = {
+		CryAudio::StringToId("domino_click"),
+		CryAudio::StringToId("domino_clatter"),
+		CryAudio::StringToId("domino_rumble") };
+
+	// Normalized 0 - 1, drive volume and sample choice inside each layer
+	const CryAudio::ControlId ImpulseParameter = CryAudio::StringToId("domino_impulse");
+	const CryAudio::ControlId DensityParameter = CryAudio::StringToId("domino_density");
+
+	// Impulse at which a click is played at full strength
+	constexpr float FullImpulse = 2.f;
+}
+
+//----------------------------------------------------------------------------------
+
+CDominoAudio::~CDominoAudio()
+{
+	Reset();
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAudio::Reset()
+{
+	for (SVoice& voice : m_voices)
+	{
+		if (voice.pObject != nullptr && gEnv->pAudioSystem != nullptr)
+			gEnv->pAudioSystem->ReleaseObject(voice.pObject);
+
+		voice = SVoice();
+	}
+
+	m_clusterCount = 0;
+	m_windowTime = 0.f;
+	m_hasCursor = false;
+	m_heardCount = m_culledCount = 0;
+	m_pendingHeard = m_pendingCulled = 0;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAudio::Update(const Vec3& listenerPosition, float frameTime)
+{
+	const CDominoCollisions& collisions = CDominoCollisions::Get();
+
+	// Contacts from before the first update are stale
+	if (!m_hasCursor)
+	{
+		m_cursor = collisions.GetCursor();
+		m_hasCursor = true;
+	}
+
+	const float cullDistance = SDominoCVars::Get().d_dominoAudioCullDistance;
+	collisions.Consume(m_cursor, [this, &listenerPosition, cullDistance](const CDominoCollisions::SContact& contact)
+		{
+			AddContact(contact, listenerPosition, cullDistance);
+		});
+
+	m_windowTime += frameTime;
+	if (m_windowTime >= m_window)
+	{
+		m_windowTime = 0.f;
+		Flush(listenerPosition);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAudio::AddContact(const CDominoCollisions::SContact& contact, const Vec3& listenerPosition, float cullDistance)
+{
+	if (contact.impulse < m_minImpulse)
+		return;
+
+	if (cullDistance > 0.f && contact.point.GetSquaredDistance(listenerPosition) > sqr(cullDistance))
+	{
+		m_pendingCulled++;
+		return;
+	}
+
+	m_pendingHeard++;
+
+	// Join the nearest cluster in reach, or open a new one while there is room,
+	// past that the contact goes to the nearest cluster wherever it is
+	size_t nearest = MaxClusters;
+	float nearestDistance = FLT_MAX;
+	for (size_t i = 0; i < m_clusterCount; i++)
+	{
+		const float distance = m_clusters[i].GetPosition().GetSquaredDistance(contact.point);
+		if (distance < nearestDistance)
+		{
+			nearest = i;
+			nearestDistance = distance;
+		}
+	}
+
+	if (nearestDistance > sqr(m_clusterRadius) && m_clusterCount < MaxClusters)
+	{
+		nearest = m_clusterCount++;
+		m_clusters[nearest] = SCluster();
+	}
+
+	SCluster& cluster = m_clusters[nearest];
+	cluster.positionSum += contact.point;
+	cluster.impulseSum += contact.impulse;
+	cluster.impulseMax = max(cluster.impulseMax, contact.impulse);
+	cluster.count++;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAudio::Flush(const Vec3& listenerPosition)
+{
+	m_heardCount = m_pendingHeard;
+	m_culledCount = m_pendingCulled;
+	m_pendingHeard = m_pendingCulled = 0;
+
+	if (m_clusterCount == 0)
+		return;
+
+	// Loudest first, so the voice limit drops the quiet ones
+	std::array<std::pair<float, size_t>, MaxClusters> order;
+	for (size_t i = 0; i < m_clusterCount; i++)
+	{
+		const SCluster& cluster = m_clusters[i];
+		const float distance = max(cluster.GetPosition().GetDistance(listenerPosition), 1.f);
+		order[i] = std::make_pair(cluster.impulseSum / distance, i);
+	}
+
+	std::sort(order.begin(), order.begin() + m_clusterCount, [](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b)
+		{
+			return a.first > b.first;
+		});
+
+	const size_t voiceCount = (size_t)clamp_tpl(SDominoCVars::Get().d_dominoAudioVoices, 0, (int)MaxVoices);
+	for (size_t i = 0; i < m_clusterCount && i < voiceCount; i++)
+	{
+		Play(m_clusters[order[i].second], order[i].first);
+	}
+
+	m_clusterCount = 0;
+}
+
+//----------------------------------------------------------------------------------
+
+CDominoAudio::ELayer CDominoAudio::GetLayer(uint32 count) const
+{
+	if (count >= m_rumbleCount)
+		return ELayer::Rumble;
+	if (count >= m_clatterCount)
+		return ELayer::Clatter;
+	return ELayer::Click;
+}
+
+//----------------------------------------------------------------------------------
+
+CDominoAudio::SVoice* CDominoAudio::AcquireVoice(float loudness, float time)
+{
+	const size_t voiceCount = (size_t)clamp_tpl(SDominoCVars::Get().d_dominoAudioVoices, 0, (int)MaxVoices);
+
+	SVoice* pOldest = nullptr;
+	SVoice* pQuietest = nullptr;
+	for (size_t i = 0; i < voiceCount; i++)
+	{
+		SVoice& voice = m_voices[i];
+		if (voice.pObject == nullptr)
+			return &voice;
+
+		if (pOldest == nullptr || voice.startTime < pOldest->startTime)
+			pOldest = &voice;
+		if (pQuietest == nullptr || voice.loudness < pQuietest->loudness)
+			pQuietest = &voice;
+	}
+
+	if (pOldest != nullptr && time - pOldest->startTime >= m_voiceDuration)
+		return pOldest;
+
+	if (pQuietest != nullptr && pQuietest->loudness < loudness)
+		return pQuietest;
+
+	return nullptr;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoAudio::Play(const SCluster& cluster, float loudness)
+{
+	if (gEnv->pAudioSystem == nullptr)
+		return;
+
+	const float time = gEnv->pTimer->GetCurrTime();
+	SVoice* pVoice = AcquireVoice(loudness, time);
+	if (pVoice == nullptr)
+		return;
+
+	if (pVoice->pObject == nullptr)
+		pVoice->pObject = gEnv->pAudioSystem->CreateObject();
+	else
+		pVoice->pObject->StopTrigger();
+
+	if (pVoice->pObject == nullptr)
+		return;
+
+	pVoice->startTime = time;
+	pVoice->loudness = loudness;
+
+	const ELayer layer = GetLayer(cluster.count);
+	pVoice->pObject->SetTransformation(CryAudio::CTransformation(Matrix34::CreateTranslationMat(cluster.GetPosition())));
+	pVoice->pObject->SetParameter(ImpulseParameter, min(cluster.impulseMax / FullImpulse, 1.f));
+	pVoice->pObject->SetParameter(DensityParameter, min((float)cluster.count / (float)m_rumbleCount, 1.f));
+	pVoice->pObject->ExecuteTrigger(LayerTriggers[(size_t)layer]);
+}
+
+//----------------------------------------------------------------------------------
+
+size_t CDominoAudio::GetActiveVoiceCount() const
+{
+	const float time = gEnv->pTimer->GetCurrTime();
+	return std::count_if(m_voices.begin(), m_voices.end(), [this, time](const SVoice& voice)
+		{
+			return voice.pObject != nullptr && time - voice.startTime < m_voiceDuration;
+		});
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+
+#include <CryAudio/IAudioSystem.h>
+
+#include "DominoCollisions.h"
+
+////////////////////////////////////////////////////////
+// Click audio for falling chains at a flat cost
+// Contacts are read in batch from CDominoCollisions and gathered into a fixed set of
+// spatial clusters over a short window. Each window ends in at most one trigger per voice,
+// layered by how many contacts its cluster holds, and culled by distance to the listener
+////////////////////////////////////////////////////////
+
+class CDominoAudio
+{
+public:
+	static constexpr size_t MaxVoices = 16;
+	static constexpr size_t MaxClusters = 32;
+
+	~CDominoAudio();
+
+	// Drains the new contacts and, at the end of each window, starts the loudest clusters
+	void Update(const Vec3& listenerPosition, float frameTime);
+	// Drops pending clusters and the audio objects, the voices are created again on demand
+	void Reset();
+
+	size_t GetActiveVoiceCount() const;
+	// Contacts heard and culled in the last window
+	size_t GetHeardCount() const { return m_heardCount; }
+	size_t GetCulledCount() const { return m_culledCount; }
+
+	// Contacts weaker than this are not heard at all
+	float m_minImpulse = .02f;
+	// Contacts closer than this to a cluster centre join it
+	float m_clusterRadius = 1.5f;
+	// Seconds contacts are gathered before the clusters are played
+	float m_window = .05f;
+	// Seconds a voice is kept before it may be reused for a quieter cluster
+	float m_voiceDuration = .3f;
+	// Contact counts from which a cluster switches to the clatter and the rumble layer
+	uint32 m_clatterCount = 4;
+	uint32 m_rumbleCount = 16;
+
+private:
+	enum class ELayer
+	{
+		Click,
+		Clatter,
+		Rumble,
+
+		Count
+	};
+
+	struct SCluster
+	{
+		Vec3 positionSum = ZERO;
+		float impulseSum = 0.f;
+		float impulseMax = 0.f;
+		uint32 count = 0;
+
+		Vec3 GetPosition() const { return positionSum / (float)count; }
+	};
+
+	struct SVoice
+	{
+		CryAudio::IObject* pObject = nullptr;
+		float startTime = -FLT_MAX;
+		float loudness = 0.f;
+	};
+
+	void AddContact(const CDominoCollisions::SContact& contact, const Vec3& listenerPosition, float cullDistance);
+	void Flush(const Vec3& listenerPosition);
+	void Play(const SCluster& cluster, float loudness);
+
+	ELayer GetLayer(uint32 count) const;
+	// Free voice, or the oldest expired one, or the quietest one if it is quieter than loudness
+	SVoice* AcquireVoice(float loudness, float time);
+
+	CDominoCollisions::Cursor m_cursor = 0;
+	bool m_hasCursor = false;
+
+	std::array<SCluster, MaxClusters> m_clusters;
+	size_t m_clusterCount = 0;
+	float m_windowTime = 0.f;
+
+	std::array<SVoice, MaxVoices> m_voices;
+
+	size_t m_heardCount = 0;
+	size_t m_culledCount = 0;
+	// Gathered during the window, published to the counters above when it ends
+	size_t m_pendingHeard = 0;
+	size_t m_pendingCulled = 0;
+};
@@ -0,0 +1,54 @@
+#include "StdAfx.h"
+#include "DominoCVars.h"
+#include "DominoPhysics.h"
+#include "Smoothing.h"
+
+#include <CrySystem/IConsole.h>
+
+void SDominoCVars::Register()
+{
+	REGISTER_CVAR2("d_dominoPipLodDistance", &d_dominoPipLodDistance, d_dominoPipLodDistance, VF_NULL, "Camera distance past which domino pips are no longer rendered");
+	REGISTER_CVAR2("d_dominoLowLodDistance", &d_dominoLowLodDistance, d_dominoLowLodDistance, VF_NULL, "Camera distance past which domino bodies switch to their low-poly LOD");
+	REGISTER_CVAR2("d_dominoLowLodRatio", &d_dominoLowLodRatio, d_dominoLowLodRatio, VF_NULL, "LOD ratio (0-255) of low-poly domino bodies");
+	REGISTER_CVAR2("d_dominoLowViewDistRatio", &d_dominoLowViewDistRatio, d_dominoLowViewDistRatio, VF_NULL, "View distance ratio (0-255) of low-poly domino bodies");
+	REGISTER_CVAR2("d_dominoDebugDraw", &d_dominoDebugDraw, d_dominoDebugDraw, VF_NULL, "Domino debug drawing: 0 off, 1 basic, 2 verbose");
+	REGISTER_CVAR2("d_dominoPhysicsProfile", &d_dominoPhysicsProfile, d_dominoPhysicsProfile, VF_NULL, "Apply the tuned domino physics profile at spawn (0 = engine defaults, for comparison)");
+	REGISTER_CVAR2_CB("d_dominoFriction", &d_dominoFriction, d_dominoFriction, VF_NULL, "Friction of the domino surface type", &DominoPhysics::OnSurfaceCVarChanged);
+	REGISTER_CVAR2_CB("d_dominoRestitution", &d_dominoRestitution, d_dominoRestitution, VF_NULL, "Bounciness of the domino surface type", &DominoPhysics::OnSurfaceCVarChanged);
+	REGISTER_CVAR2("d_dominoDamping", &d_dominoDamping, d_dominoDamping, VF_NULL, "Linear and angular damping of domino bodies");
+	REGISTER_CVAR2("d_dominoSleepEnergy", &d_dominoSleepEnergy, d_dominoSleepEnergy, VF_NULL, "Energy threshold below which domino bodies fall asleep");
+	REGISTER_CVAR2("d_dominoMaxTimeStep", &d_dominoMaxTimeStep, d_dominoMaxTimeStep, VF_NULL, "Maximum physics sub-step of domino bodies");
+	REGISTER_CVAR2("d_dominoMemoryBudget", &d_dominoMemoryBudget, d_dominoMemoryBudget, VF_NULL, "Memory budget of the domino layout in MB (0 = no budget)");
+	REGISTER_CVAR2("d_dominoMemoryBudgetRefuse", &d_dominoMemoryBudgetRefuse, d_dominoMemoryBudgetRefuse, VF_NULL, "Placing past d_dominoMemoryBudget: 0 warns, 1 refuses the placement");
+	REGISTER_CVAR2("d_dominoAudioVoices", &d_dominoAudioVoices, d_dominoAudioVoices, VF_NULL, "Maximum number of domino sounds playing at once");
+	REGISTER_CVAR2("d_dominoAudioCullDistance", &d_dominoAudioCullDistance, d_dominoAudioCullDistance, VF_NULL, "Listener distance past which domino contacts are not heard (0 = no culling)");
+	REGISTER_CVAR2("d_dominoTelemetry", &d_dominoTelemetry, d_dominoTelemetry, VF_NULL, "Chain telemetry: 0 off, 1 record each run, 2 also export it to %USER%/DominoTelemetry");
+	REGISTER_CVAR2("d_dominoAutosave", &d_dominoAutosave, d_dominoAutosave, VF_NULL, "Journal every stroke, undo and redo in the background and recover them at startup");
+
+	REGISTER_COMMAND("d_dominoCheckSmoothing", &Smoothing::CheckFrameRateIndependenceCommand, VF_NULL, "Steps the camera smoothing at 30, 60 and 144 fps and logs whether the trajectories agree");
+}
+
+void SDominoCVars::Unregister()
+{
+	if (gEnv->pConsole == nullptr)
+		return;
+
+	gEnv->pConsole->UnregisterVariable("d_dominoPipLodDistance", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoLowLodDistance", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoLowLodRatio", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoLowViewDistRatio", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoDebugDraw", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoPhysicsProfile", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoFriction", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoRestitution", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoDamping", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoSleepEnergy", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoMaxTimeStep", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoMemoryBudget", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoMemoryBudgetRefuse", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoAudioVoices", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoAudioCullDistance", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoTelemetry", true);
+	gEnv->pConsole->UnregisterVariable("d_dominoAutosave", true);
+	gEnv->pConsole->RemoveCommand("d_dominoCheckSmoothing");
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+////////////////////////////////////////////////////////
+// Console variables tuning the domino subsystem
+////////////////////////////////////////////////////////
+
+struct SDominoCVars
+{
+	// Past this camera distance the pip sub-meshes are not rendered
+	float d_dominoPipLodDistance = 25.f;
+	// Past this camera distance the body drops to its low-poly LOD
+	float d_dominoLowLodDistance = 60.f;
+	// LOD ratio used for low-poly bodies, 0 - 255
+	int d_dominoLowLodRatio = 10;
+	// View distance ratio used for low-poly bodies, 0 - 255
+	int d_dominoLowViewDistRatio = 100;
+	// 0 off, 1 basic markers, 2 verbose placement state
+	int d_dominoDebugDraw = 0;
+
+	// Physics profile applied to every piece at spawn, see DominoPhysics.h
+	int d_dominoPhysicsProfile = 1;
+	float d_dominoFriction = .45f;
+	float d_dominoRestitution = .05f;
+	float d_dominoDamping = .05f;
+	// Kinetic energy per unit mass below which a piece may fall asleep
+	float d_dominoSleepEnergy = .002f;
+	float d_dominoMaxTimeStep = .01f;
+
+	// Memory budget of the domino layout in MB, 0 disables the check
+	float d_dominoMemoryBudget = 0.f;
+	// 0 warns when placing past the budget, 1 refuses the placement
+	int d_dominoMemoryBudgetRefuse = 0;
+
+	// Upper bound of domino sounds playing at once, see DominoAudio.h
+	int d_dominoAudioVoices = 8;
+	// Contacts farther than this from the listener are not heard, 0 disables culling
+	float d_dominoAudioCullDistance = 60.f;
+
+	// 0 off, 1 records a timeline of each run, 2 also exports it, see ChainTelemetry.h
+	int d_dominoTelemetry = 0;
+
+	// Journals the layout history to %USER%/DominoLayout.journal and recovers it at startup
+	int d_dominoAutosave = 1;
+
+	void Register();
+	void Unregister();
+
+	static SDominoCVars& Get()
+	{
+		static SDominoCVars instance;
+		return instance;
+	}
+};
@@ -0,0 +1,102 @@
+#include "StdAfx.h"
+#include "DominoChunkBaker.h"
+
+//----------------------------------------------------------------------------------
+
+void CDominoChunkBaker::LoadSources()
+{
+	if (m_pBody)
+		return;
+
+	// Same assets CDominoComponent loads into its slots
+	m_pBody = gEnv->p3DEngine->LoadStatObj(DominoAssets::BodyGeometry);
+	for (int i = 0; i < 4; i++)
+	{
+		m_pips[i] = gEnv->p3DEngine->LoadStatObj(DominoAssets::PipGeometry[i]);
+	}
+
+	m_pBodyMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial(DominoAssets::BodyMaterial);
+	for (int i = 0; i < DominoAssets::PipValueCount; i++)
+	{
+		m_pipMaterials[i] = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial(DominoAssets::PipMaterialPrefix + ToString(i + 1));
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+IEntity* CDominoChunkBaker::Bake(const std::vector<SPiece>& pieces, const Vec3& origin)
+{
+	if (pieces.empty())
+		return nullptr;
+
+	LoadSources();
+	if (!m_pBody)
+		return nullptr;
+
+	// Slot 0 holds the bodies, slot n the pips showing value n
+	std::array<_smart_ptr<IStatObj>, DominoAssets::PipValueCount + 1> compounds;
+	for (_smart_ptr<IStatObj>& pCompound : compounds)
+	{
+		pCompound = gEnv->p3DEngine->CreateStatObj();
+		pCompound->SetFlags(pCompound->GetFlags() | STATIC_OBJECT_COMPOUND);
+	}
+
+	for (const SPiece& piece : pieces)
+	{
+		const Matrix34 localTM = Matrix34::Create(Vec3(piece.scale), piece.rotation, piece.position - origin);
+
+		compounds[0]->AddSubObject(m_pBody).localTM = localTM;
+
+		for (int i = 0; i < 4; i++)
+		{
+			const int value = clamp_tpl((int)piece.pips[i], 1, DominoAssets::PipValueCount);
+			if (m_pips[i])
+			{
+				compounds[value]->AddSubObject(m_pips[i]).localTM = localTM;
+			}
+		}
+	}
+
+	SEntitySpawnParams spawnParams;
+	spawnParams.pClass = gEnv->pEntitySystem->GetClassRegistry()->GetDefaultClass();
+	spawnParams.vPosition = origin;
+	spawnParams.nFlags = ENTITY_FLAG_CLIENT_ONLY;
+
+	IEntity* pEntity = gEnv->pEntitySystem->SpawnEntity(spawnParams);
+	if (pEntity == nullptr)
+		return nullptr;
+
+	for (int slot = 0; slot < (int)compounds.size(); slot++)
+	{
+		if (compounds[slot]->GetSubObjectCount() == 0)
+			continue;
+
+		// Rebuilds the compound, with e_StatObjMerge the sub-objects are merged into a single render mesh
+		compounds[slot]->Invalidate(false);
+
+		pEntity->SetStatObj(compounds[slot], slot, false);
+		pEntity->SetSlotMaterial(slot, slot == 0 ? m_pBodyMaterial : m_pipMaterials[slot - 1]);
+	}
+
+	pEntity->SetViewDistRatio(255);
+
+	return pEntity;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoChunkBaker::Release(EntityId bakedEntityId)
+{
+	if (bakedEntityId != INVALID_ENTITYID)
+		gEnv->pEntitySystem->RemoveEntity(bakedEntityId);
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoChunkBaker::Clear()
+{
+	m_pBody = nullptr;
+	m_pips.fill(nullptr);
+	m_pBodyMaterial = nullptr;
+	m_pipMaterials.fill(nullptr);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <CryEntitySystem/IEntitySystem.h>
+#include <Cry3DEngine/IStatObj.h>
+
+#include "DominoKind.h"
+
+////////////////////////////////////////////////////////
+// Merges resting dominoes into one entity per chunk
+// Bodies go into a single compound mesh, pips into one compound per pip value,
+// so a chunk costs 7 merged objects instead of 5 render slots per piece
+////////////////////////////////////////////////////////
+
+class CDominoChunkBaker
+{
+public:
+	struct SPiece
+	{
+		Vec3 position;
+		Quat rotation;
+		float scale;
+		std::array<uint8, 4> pips;
+	};
+
+	// Spawns the baked chunk entity, pieces are in world space
+	IEntity* Bake(const std::vector<SPiece>& pieces, const Vec3& origin);
+	void Release(EntityId bakedEntityId);
+
+	// Drops the cached source geometry and materials
+	void Clear();
+
+private:
+	void LoadSources();
+
+	_smart_ptr<IStatObj> m_pBody;
+	std::array<_smart_ptr<IStatObj>, 4> m_pips;
+
+	_smart_ptr<IMaterial> m_pBodyMaterial;
+	std::array<_smart_ptr<IMaterial>, DominoAssets::PipValueCount> m_pipMaterials;
+};
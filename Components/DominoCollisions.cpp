@@ -0,0 +1,64 @@
+#include "StdAfx.h"
+#include "DominoCollisions.h"
+
+#include "DominoPhysics.h"
+
+#include <CryEntitySystem/IEntity.h>
+
+//----------------------------------------------------------------------------------
+
+void CDominoCollisions::Register()
+{
+	if (m_isRegistered || gEnv->pPhysicalWorld == nullptr)
+		return;
+
+	// Logged events are delivered on the main thread, no locking needed around the ring
+	gEnv->pPhysicalWorld->AddEventClient(EventPhysCollision::id, &CDominoCollisions::OnCollision, 1);
+	m_isRegistered = true;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoCollisions::Unregister()
+{
+	if (!m_isRegistered || gEnv->pPhysicalWorld == nullptr)
+		return;
+
+	gEnv->pPhysicalWorld->RemoveEventClient(EventPhysCollision::id, &CDominoCollisions::OnCollision, 1);
+	m_isRegistered = false;
+}
+
+//----------------------------------------------------------------------------------
+
+int CDominoCollisions::OnCollision(const EventPhys* pEvent)
+{
+	const EventPhysCollision* pCollision = static_cast<const EventPhysCollision*>(pEvent);
+
+	// Pieces are told apart by the flag they were tagged with when physicalized, their surface follows d_dominoPhysicsProfile
+	uint8 dominoMask = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		if (DominoPhysics::IsDomino(pCollision->pEntity[i]))
+			dominoMask |= 1 << i;
+	}
+
+	if (dominoMask == 0)
+		return 1;
+
+	CDominoCollisions& collisions = Get();
+	SContact& contact = collisions.m_contacts[collisions.m_written & (Capacity - 1)];
+
+	contact.point = pCollision->pt;
+	contact.impulse = pCollision->normImpulse;
+	contact.speed = (pCollision->vloc[0] - pCollision->vloc[1]).GetLength();
+	contact.dominoMask = dominoMask;
+
+	for (int i = 0; i < 2; i++)
+	{
+		IEntity* pEntity = pCollision->iForeignData[i] == PHYS_FOREIGN_ID_ENTITY ? static_cast<IEntity*>(pCollision->pForeignData[i]) : nullptr;
+		contact.entityIds[i] = pEntity != nullptr ? pEntity->GetId() : INVALID_ENTITYID;
+	}
+
+	collisions.m_written++;
+	return 1;
+}
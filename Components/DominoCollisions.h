@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+
+#include <CryPhysics/IPhysics.h>
+
+////////////////////////////////////////////////////////
+// One physics-world listener for every domino contact
+// Contacts are written as compact records into a fixed ring, each consumer
+// (wavefront, sound, stats) keeps its own cursor and drains them in one batch
+////////////////////////////////////////////////////////
+
+class CDominoCollisions
+{
+public:
+	static constexpr size_t Capacity = 4096;
+
+	struct SContact
+	{
+		Vec3 point;
+		// Impulse along the contact normal
+		float impulse;
+		// Relative speed of the two bodies at the contact
+		float speed;
+		EntityId entityIds[2];
+		// 1 if only the first body is a domino, 2 if only the second, 3 if both
+		uint8 dominoMask;
+	};
+
+	// Sequence number of the next contact, consumers start reading from here
+	typedef uint64 Cursor;
+
+	void Register();
+	void Unregister();
+
+	Cursor GetCursor() const { return m_written; }
+
+	// Calls func for every contact written since cursor and moves the cursor past them
+	// Contacts older than Capacity are gone and skipped, returns how many were
+	template<typename TFunc>
+	size_t Consume(Cursor& cursor, TFunc&& func) const
+	{
+		size_t dropped = 0;
+		if (m_written - cursor > Capacity)
+		{
+			dropped = (size_t)(m_written - cursor - Capacity);
+			cursor = m_written - Capacity;
+		}
+
+		for (; cursor < m_written; cursor++)
+		{
+			func(m_contacts[cursor & (Capacity - 1)]);
+		}
+
+		return dropped;
+	}
+
+	static CDominoCollisions& Get()
+	{
+		static CDominoCollisions instance;
+		return instance;
+	}
+
+private:
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity shall be a power of two!");
+
+	static int OnCollision(const EventPhys* pEvent);
+
+	std::array<SContact, Capacity> m_contacts;
+	Cursor m_written = 0;
+	bool m_isRegistered = false;
+};
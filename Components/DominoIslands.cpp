@@ -0,0 +1,221 @@
+#include "StdAfx.h"
+#include "DominoIslands.h"
+
+#include <numeric>
+
+namespace
+{
+	// Union-find root with path halving
+	uint32 FindRoot(std::vector<uint32>& parents, uint32 i)
+	{
+		while (parents[i] != i)
+		{
+			parents[i] = parents[parents[i]];
+			i = parents[i];
+		}
+		return i;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+uint64 CDominoIslands::GetGridKey(const Vec3& position) const
+{
+	const int32 x = (int32)floor_tpl(position.x / m_gridSize);
+	const int32 y = (int32)floor_tpl(position.y / m_gridSize);
+	return ((uint64)(uint32)x << 32) | (uint64)(uint32)y;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoIslands::Clear()
+{
+	m_islandOfId.clear();
+	m_islands.clear();
+	m_grid.clear();
+	m_liveCount = 0;
+	m_largestSize = 0;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoIslands::Build(const CDominoWorldPartition& partition)
+{
+	Clear();
+
+	const size_t idCount = partition.GetIdCount();
+	m_islandOfId.assign(idCount, InvalidIsland);
+
+	// Any link is shorter than the longest reach, so the 3x3 cells around a piece hold all of its links
+	m_gridSize = 0.f;
+	for (size_t kind = 0; kind < (size_t)EDominoKind::Count; kind++)
+	{
+		m_gridSize = max(m_gridSize, CDominoKindRegistry::Get((EDominoKind)kind).reach);
+	}
+
+	for (DominoId id = 0; id < (DominoId)idCount; id++)
+	{
+		const CDominoWorldPartition::SDominoRecord& record = partition.GetRecord(id);
+		if (!record.isRemoved && !partition.IsHidden(id))
+			m_grid[GetGridKey(record.restPosition)].push_back(id);
+	}
+
+	std::vector<uint32> parents(idCount);
+	std::iota(parents.begin(), parents.end(), 0u);
+
+	for (const std::pair<const uint64, std::vector<DominoId>>& cell : m_grid)
+	{
+		for (DominoId id : cell.second)
+		{
+			const CDominoWorldPartition::SDominoRecord& record = partition.GetRecord(id);
+			const float reach = CDominoKindRegistry::Get(record.kind).reach;
+
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					auto it = m_grid.find(GetGridKey(record.restPosition + Vec3(dx * m_gridSize, dy * m_gridSize, 0)));
+					if (it == m_grid.end())
+						continue;
+
+					// Each piece only links what it can reach, the reverse link comes from the other side
+					for (DominoId other : it->second)
+					{
+						if (other == id || record.restPosition.GetSquaredDistance(partition.GetRecord(other).restPosition) > sqr(reach))
+							continue;
+
+						const uint32 a = FindRoot(parents, id);
+						const uint32 b = FindRoot(parents, other);
+						if (a != b)
+							parents[max(a, b)] = min(a, b);
+					}
+				}
+			}
+		}
+	}
+
+	// Number the roots in id order so the island ids are stable for an unchanged layout
+	std::vector<IslandId> islandOfRoot(idCount, InvalidIsland);
+	for (DominoId id = 0; id < (DominoId)idCount; id++)
+	{
+		const CDominoWorldPartition::SDominoRecord& record = partition.GetRecord(id);
+		if (record.isRemoved || partition.IsHidden(id))
+			continue;
+
+		const uint32 root = FindRoot(parents, id);
+		if (islandOfRoot[root] == InvalidIsland)
+		{
+			islandOfRoot[root] = (IslandId)m_islands.size();
+			m_islands.emplace_back();
+		}
+
+		m_islandOfId[id] = islandOfRoot[root];
+		m_islands[islandOfRoot[root]].dominoes.push_back(id);
+	}
+
+	for (const SIsland& island : m_islands)
+	{
+		m_largestSize = max(m_largestSize, island.dominoes.size());
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoIslands::Begin()
+{
+	const float time = gEnv->pTimer->GetCurrTime();
+	for (SIsland& island : m_islands)
+	{
+		island.lastContactTime = time;
+		island.isSettled = false;
+	}
+
+	m_liveCount = m_islands.size();
+	m_contactCursor = CDominoCollisions::Get().GetCursor();
+}
+
+//----------------------------------------------------------------------------------
+
+CDominoIslands::DominoId CDominoIslands::FindNearest(const CDominoWorldPartition& partition, const Vec3& position) const
+{
+	DominoId nearest = CDominoWorldPartition::InvalidId;
+	float nearestDistance = sqr(m_gridSize);
+
+	for (int dx = -1; dx <= 1; dx++)
+	{
+		for (int dy = -1; dy <= 1; dy++)
+		{
+			auto it = m_grid.find(GetGridKey(position + Vec3(dx * m_gridSize, dy * m_gridSize, 0)));
+			if (it == m_grid.end())
+				continue;
+
+			for (DominoId id : it->second)
+			{
+				const float distance = partition.GetRecord(id).restPosition.GetSquaredDistance2D(position);
+				if (distance < nearestDistance)
+				{
+					nearest = id;
+					nearestDistance = distance;
+				}
+			}
+		}
+	}
+
+	return nearest;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoIslands::Update(CDominoWorldPartition& partition)
+{
+	const float time = gEnv->pTimer->GetCurrTime();
+
+	// A falling piece never leaves the reach of its rest pose, its contacts find its island
+	CDominoCollisions::Get().Consume(m_contactCursor, [this, &partition, time](const CDominoCollisions::SContact& contact)
+		{
+			const IslandId island = GetIsland(FindNearest(partition, contact.point));
+			if (island == InvalidIsland)
+				return;
+
+			SIsland& target = m_islands[island];
+			target.lastContactTime = time;
+			if (target.isSettled)
+			{
+				target.isSettled = false;
+				m_liveCount++;
+			}
+		});
+
+	for (SIsland& island : m_islands)
+	{
+		if (island.isSettled || time - island.lastContactTime < m_settleTime)
+			continue;
+
+		island.isSettled = true;
+		m_liveCount--;
+
+		for (DominoId id : island.dominoes)
+		{
+			IEntity* pEntity = partition.GetEntity(id);
+			if (IPhysicalEntity* pPhysics = pEntity != nullptr ? pEntity->GetPhysics() : nullptr)
+			{
+				pe_action_awake awake;
+				awake.bAwake = 0;
+				pPhysics->Action(&awake);
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoIslands::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddContainer(m_islandOfId);
+	pSizer->AddContainer(m_islands);
+	for (const SIsland& island : m_islands)
+	{
+		pSizer->AddContainer(island.dominoes);
+	}
+	pSizer->AddContainer(m_grid);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "DominoWorldPartition.h"
+
+////////////////////////////////////////////////////////
+// Splits a layout into islands of dominoes that can never push each other
+// Two pieces share an island when either stands within the other's topple reach.
+// While simulating, an island without contacts for a while is put to sleep as a whole,
+// so the physics workers only solve the islands that are still falling
+////////////////////////////////////////////////////////
+
+class CDominoIslands
+{
+public:
+	typedef CDominoWorldPartition::DominoId DominoId;
+	typedef uint32 IslandId;
+	static constexpr IslandId InvalidIsland = ~0u;
+
+	// Connectivity of every visible domino from its rest pose, O(n) over a reach-sized grid
+	void Build(const CDominoWorldPartition& partition);
+	void Clear();
+
+	// Marks every island live, call when the simulation starts
+	void Begin();
+	// Reads the new domino contacts and puts islands that went quiet to sleep
+	void Update(CDominoWorldPartition& partition);
+
+	IslandId GetIsland(DominoId id) const { return id < m_islandOfId.size() ? m_islandOfId[id] : InvalidIsland; }
+	const std::vector<DominoId>& GetDominoes(IslandId island) const { return m_islands[island].dominoes; }
+
+	size_t GetCount() const { return m_islands.size(); }
+	size_t GetLiveCount() const { return m_liveCount; }
+	size_t GetLargestSize() const { return m_largestSize; }
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+	// Seconds without a contact after which an island is put to sleep
+	float m_settleTime = 3.f;
+
+private:
+	struct SIsland
+	{
+		std::vector<DominoId> dominoes;
+		float lastContactTime = -FLT_MAX;
+		bool isSettled = true;
+	};
+
+	uint64 GetGridKey(const Vec3& position) const;
+	// Closest visible domino within reach of the point, InvalidId if none
+	DominoId FindNearest(const CDominoWorldPartition& partition, const Vec3& position) const;
+
+	std::vector<IslandId> m_islandOfId;
+	std::vector<SIsland> m_islands;
+
+	// Grid of visible domino ids, cells are as large as the longest reach
+	std::unordered_map<uint64, std::vector<DominoId>> m_grid;
+	float m_gridSize = 1.f;
+
+	CDominoCollisions::Cursor m_contactCursor = 0;
+	size_t m_liveCount = 0;
+	size_t m_largestSize = 0;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+
+////////////////////////////////////////////////////////
+// Domino kinds
+// Each kind's geometry and physics constants live in a compile-time traits
+// specialization, code that is templated on the kind folds them away.
+// CDominoKindRegistry exposes the same values at runtime for mixed layouts
+////////////////////////////////////////////////////////
+
+enum class EDominoKind : uint8
+{
+	Standard = 0,
+	Mini,
+	Giant,
+
+	Count
+};
+
+namespace DominoAssets
+{
+	static constexpr const char* BodyGeometry = "Objects/Dominoes.cgf";
+	static constexpr const char* BodyMaterial = "Objects/dominoes1";
+	// Pip sub-meshes, loaded into slots 1-4
+	static constexpr const char* PipGeometry[4] = { "Objects/Domino/1.cgf", "Objects/Domino/2.cgf", "Objects/Domino/3.cgf", "Objects/Domino/4.cgf" };
+	// Pip value materials are PipMaterialPrefix + 1-6
+	static constexpr const char* PipMaterialPrefix = "materials/domino/";
+	static constexpr int PipValueCount = 6;
+}
+
+namespace DominoWorld
+{
+	static constexpr float WaterLevel = 16.f;
+}
+
+template<EDominoKind KIND>
+struct SDominoKindTraits;
+
+// All kinds share the standard meshes, scaled
+template<>
+struct SDominoKindTraits<EDominoKind::Standard>
+{
+	static constexpr const char* Name = "Standard";
+	static constexpr float Scale = 1.f;
+	static constexpr float Height = .45f;
+	static constexpr float Width = .22f;
+	static constexpr float Thickness = .08f;
+	static constexpr float Mass = 1.f;
+	// Distance between two consecutive pieces of a stroke
+	static constexpr float Spacing = .3f;
+};
+
+template<>
+struct SDominoKindTraits<EDominoKind::Mini>
+{
+	static constexpr const char* Name = "Mini";
+	static constexpr float Scale = .5f;
+	static constexpr float Height = SDominoKindTraits<EDominoKind::Standard>::Height * Scale;
+	static constexpr float Width = SDominoKindTraits<EDominoKind::Standard>::Width * Scale;
+	static constexpr float Thickness = SDominoKindTraits<EDominoKind::Standard>::Thickness * Scale;
+	static constexpr float Mass = SDominoKindTraits<EDominoKind::Standard>::Mass * Scale * Scale * Scale;
+	static constexpr float Spacing = SDominoKindTraits<EDominoKind::Standard>::Spacing * Scale;
+};
+
+template<>
+struct SDominoKindTraits<EDominoKind::Giant>
+{
+	static constexpr const char* Name = "Giant";
+	static constexpr float Scale = 3.f;
+	static constexpr float Height = SDominoKindTraits<EDominoKind::Standard>::Height * Scale;
+	static constexpr float Width = SDominoKindTraits<EDominoKind::Standard>::Width * Scale;
+	static constexpr float Thickness = SDominoKindTraits<EDominoKind::Standard>::Thickness * Scale;
+	static constexpr float Mass = SDominoKindTraits<EDominoKind::Standard>::Mass * Scale * Scale * Scale;
+	static constexpr float Spacing = SDominoKindTraits<EDominoKind::Standard>::Spacing * Scale;
+};
+
+// How far in front of its pivot a falling piece of this kind can push
+template<EDominoKind KIND>
+constexpr float GetDominoReach()
+{
+	return SDominoKindTraits<KIND>::Height + SDominoKindTraits<KIND>::Thickness * .5f;
+}
+
+// Runtime view of a kind's traits
+struct SDominoKindDesc
+{
+	const char* name;
+	float scale;
+	float height;
+	float width;
+	float thickness;
+	float mass;
+	float spacing;
+	float reach;
+};
+
+template<EDominoKind KIND>
+constexpr SDominoKindDesc MakeDominoKindDesc()
+{
+	typedef SDominoKindTraits<KIND> Traits;
+	return SDominoKindDesc { Traits::Name, Traits::Scale, Traits::Height, Traits::Width, Traits::Thickness, Traits::Mass, Traits::Spacing, GetDominoReach<KIND>() };
+}
+
+// Calls func with an SDominoKindTraits instance matching the runtime kind,
+// so generic lambdas can be written once and instantiated per kind
+template<typename TFunc>
+inline auto DispatchDominoKind(EDominoKind kind, TFunc&& func) -> decltype(func(SDominoKindTraits<EDominoKind::Standard>()))
+{
+	switch (kind)
+	{
+	case EDominoKind::Mini:
+		return func(SDominoKindTraits<EDominoKind::Mini>());
+	case EDominoKind::Giant:
+		return func(SDominoKindTraits<EDominoKind::Giant>());
+	case EDominoKind::Standard:
+	default:
+		return func(SDominoKindTraits<EDominoKind::Standard>());
+	}
+}
+
+class CDominoKindRegistry
+{
+public:
+	static const SDominoKindDesc& Get(EDominoKind kind)
+	{
+		static const std::array<SDominoKindDesc, (size_t)EDominoKind::Count> descs = {{
+			MakeDominoKindDesc<EDominoKind::Standard>(),
+			MakeDominoKindDesc<EDominoKind::Mini>(),
+			MakeDominoKindDesc<EDominoKind::Giant>()
+		}};
+
+		return descs[(size_t)kind < descs.size() ? (size_t)kind : 0];
+	}
+
+	static EDominoKind Next(EDominoKind kind)
+	{
+		return (EDominoKind)(((size_t)kind + 1) % (size_t)EDominoKind::Count);
+	}
+};
@@ -0,0 +1,115 @@
+#include "StdAfx.h"
+#include "DominoPhysics.h"
+
+#include "DominoCVars.h"
+
+#include <Cry3DEngine/I3DEngine.h>
+
+namespace DominoPhysics
+{
+	// Index of mat_domino, 0 (the default surface) if the game data doesn't define it
+	static int ResolveSurfaceIndex()
+	{
+		ISurfaceType* pSurfaceType = gEnv->p3DEngine->GetMaterialManager()->GetSurfaceTypeManager()->GetSurfaceTypeByName(SurfaceTypeName, nullptr, false);
+		if (pSurfaceType == nullptr)
+		{
+			CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "DominoPhysics: Surface type %s is missing, dominoes use the default surface", SurfaceTypeName);
+			return 0;
+		}
+
+		return pSurfaceType->GetId();
+	}
+
+	//----------------------------------------------------------------------------------
+
+	int GetSurfaceIndex()
+	{
+		static const int surfaceIndex = ResolveSurfaceIndex();
+		return surfaceIndex;
+	}
+
+	//----------------------------------------------------------------------------------
+
+	void ApplySurfaceParameters()
+	{
+		// Without mat_domino the tuning would overwrite the default surface everything else uses
+		if (gEnv->pPhysicalWorld == nullptr || GetSurfaceIndex() == 0)
+			return;
+
+		const SDominoCVars& cvars = SDominoCVars::Get();
+		gEnv->pPhysicalWorld->SetSurfaceParameters(GetSurfaceIndex(), cvars.d_dominoRestitution, cvars.d_dominoFriction);
+	}
+
+	//----------------------------------------------------------------------------------
+
+	void OnSurfaceCVarChanged(ICVar* pCVar)
+	{
+		ApplySurfaceParameters();
+	}
+
+	//----------------------------------------------------------------------------------
+
+	void AddBoxProxy(IPhysicalEntity* pPhysics, const Vec3& size, const Vec3& center, float mass)
+	{
+		if (pPhysics == nullptr)
+			return;
+
+		primitives::box box;
+		box.Basis.SetIdentity();
+		box.bOriented = 0;
+		box.size = size * .5f;
+		box.center = center;
+
+		IGeomManager* pGeomManager = gEnv->pPhysicalWorld->GetGeomManager();
+		IGeometry* pGeometry = pGeomManager->CreatePrimitive(primitives::box::type, &box);
+
+		const int surfaceIndex = SDominoCVars::Get().d_dominoPhysicsProfile != 0 ? GetSurfaceIndex() : 0;
+		phys_geometry* pPhysGeometry = pGeomManager->RegisterGeometry(pGeometry, surfaceIndex);
+		pGeometry->Release();
+
+		pe_geomparams geomParams;
+		geomParams.flags = geom_collides | geom_floats;
+		geomParams.mass = mass;
+		pPhysics->AddGeometry(pPhysGeometry, &geomParams);
+
+		// The entity holds its own reference now
+		pGeomManager->UnregisterGeometry(pPhysGeometry);
+	}
+
+	//----------------------------------------------------------------------------------
+
+	void ApplyProfile(IPhysicalEntity* pPhysics, float mass)
+	{
+		const SDominoCVars& cvars = SDominoCVars::Get();
+		if (pPhysics == nullptr || cvars.d_dominoPhysicsProfile == 0)
+			return;
+
+		pe_simulation_params simParams;
+		simParams.mass = mass;
+		simParams.damping = cvars.d_dominoDamping;
+		simParams.dampingFreefall = cvars.d_dominoDamping;
+		simParams.minEnergy = cvars.d_dominoSleepEnergy;
+		simParams.maxTimeStep = cvars.d_dominoMaxTimeStep;
+		pPhysics->SetParams(&simParams);
+	}
+
+	//----------------------------------------------------------------------------------
+
+	void Tag(IPhysicalEntity* pPhysics)
+	{
+		if (pPhysics == nullptr)
+			return;
+
+		pe_params_foreign_data foreignData;
+		foreignData.iForeignFlagsOR = ForeignFlag;
+		pPhysics->SetParams(&foreignData);
+	}
+
+	//----------------------------------------------------------------------------------
+
+	bool IsDomino(IPhysicalEntity* pPhysics)
+	{
+		pe_params_foreign_data foreignData;
+		return pPhysics != nullptr && pPhysics->GetParams(&foreignData) && (foreignData.iForeignFlags & ForeignFlag) != 0;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <CryPhysics/IPhysics.h>
+
+struct ICVar;
+
+////////////////////////////////////////////////////////
+// Physics profile tuned for long domino chains
+// Pieces collide as a single box on their own surface type, with per-body damping
+// and sleep settings, so resting stacks go to sleep instead of eating solver iterations
+////////////////////////////////////////////////////////
+
+namespace DominoPhysics
+{
+	// Name expected in the game's surfacetypes.xml
+	static constexpr const char* SurfaceTypeName = "mat_domino";
+
+	// Physics surface index of the domino surface, the default surface (0) if the game data lacks it
+	int GetSurfaceIndex();
+	// Writes d_dominoFriction and d_dominoRestitution into the physics surface table, the table is global
+	// so this runs once at startup and again whenever one of them changes, never per piece
+	void ApplySurfaceParameters();
+	void OnSurfaceCVarChanged(ICVar* pCVar);
+
+	// Adds the single analytic box the piece collides with, size and center in the entity's local space
+	void AddBoxProxy(IPhysicalEntity* pPhysics, const Vec3& size, const Vec3& center, float mass);
+
+	// Applies the profile to a freshly physicalized piece, mass is the piece kind's mass
+	void ApplyProfile(IPhysicalEntity* pPhysics, float mass);
+
+	// Foreign flag every piece's physical entity carries, well above the engine's PFF_ flags
+	static constexpr int ForeignFlag = 1 << 14;
+	// Sets ForeignFlag, once when the piece is physicalized
+	void Tag(IPhysicalEntity* pPhysics);
+	// Reads the flag back, no entity or component lookup
+	bool IsDomino(IPhysicalEntity* pPhysics);
+}
@@ -0,0 +1,277 @@
+#include "StdAfx.h"
+#include "DominoPicker.h"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define DOMINO_PICKER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define DOMINO_PICKER_SSE 1
+#endif
+
+namespace
+{
+	// Far enough that no pick reaches it, and finite so the slab math stays NaN free
+	constexpr float PaddingDistance = 1e18f;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoPicker::Clear()
+{
+	for (std::vector<float>* pArray : { &m_centerX, &m_centerY, &m_centerZ, &m_axisXx, &m_axisXy, &m_axisXz, &m_axisYx, &m_axisYy, &m_axisYz, &m_axisZx, &m_axisZy, &m_axisZz, &m_halfX, &m_halfY, &m_halfZ })
+	{
+		pArray->clear();
+	}
+
+	m_ids.clear();
+	m_indices.clear();
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoPicker::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	for (const std::vector<float>* pArray : { &m_centerX, &m_centerY, &m_centerZ, &m_axisXx, &m_axisXy, &m_axisXz, &m_axisYx, &m_axisYy, &m_axisYz, &m_axisZx, &m_axisZy, &m_axisZz, &m_halfX, &m_halfY, &m_halfZ })
+	{
+		pSizer->AddContainer(*pArray);
+	}
+
+	pSizer->AddContainer(m_ids);
+	pSizer->AddContainer(m_indices);
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoPicker::PushBox(DominoId id, const Vec3& center, const Matrix33& axes, const Vec3& halfSize)
+{
+	m_centerX.push_back(center.x);
+	m_centerY.push_back(center.y);
+	m_centerZ.push_back(center.z);
+
+	// Columns of the box rotation, dotting with them moves into box space
+	m_axisXx.push_back(axes.m00); m_axisXy.push_back(axes.m10); m_axisXz.push_back(axes.m20);
+	m_axisYx.push_back(axes.m01); m_axisYy.push_back(axes.m11); m_axisYz.push_back(axes.m21);
+	m_axisZx.push_back(axes.m02); m_axisZy.push_back(axes.m12); m_axisZz.push_back(axes.m22);
+
+	m_halfX.push_back(halfSize.x);
+	m_halfY.push_back(halfSize.y);
+	m_halfZ.push_back(halfSize.z);
+
+	m_ids.push_back(id);
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoPicker::Rebuild(const CDominoWorldPartition& partition)
+{
+	Clear();
+
+	const size_t idCount = partition.GetIdCount();
+	m_indices.assign(idCount, ~0u);
+
+	for (DominoId id = 0; id < (DominoId)idCount; id++)
+	{
+		const CDominoWorldPartition::SDominoRecord& record = partition.GetRecord(id);
+		if (record.isRemoved || partition.IsHidden(id))
+			continue;
+
+		// Same box the piece collides with, standing on its pivot
+		const SDominoKindDesc& kind = CDominoKindRegistry::Get(record.kind);
+		const Matrix33 axes(record.restRotation);
+		const Vec3 halfSize(kind.width * .5f, kind.thickness * .5f, kind.height * .5f);
+
+		m_indices[id] = (uint32)m_ids.size();
+		PushBox(id, record.restPosition + axes.GetColumn2() * halfSize.z, axes, halfSize);
+	}
+
+	// Pad to whole blocks so the SIMD loop has no tail
+	while (m_ids.size() % BlockSize != 0)
+	{
+		PushBox(CDominoWorldPartition::InvalidId, Vec3(PaddingDistance), Matrix33(IDENTITY), Vec3(ZERO));
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool CDominoPicker::GetBox(DominoId id, OBB& box, Vec3& center) const
+{
+	if (id >= m_indices.size() || m_indices[id] == ~0u)
+		return false;
+
+	const size_t i = m_indices[id];
+	Matrix33 axes;
+	axes.SetFromVectors(
+		Vec3(m_axisXx[i], m_axisXy[i], m_axisXz[i]),
+		Vec3(m_axisYx[i], m_axisYy[i], m_axisYz[i]),
+		Vec3(m_axisZx[i], m_axisZy[i], m_axisZz[i]));
+
+	box = OBB::CreateOBB(axes, Vec3(m_halfX[i], m_halfY[i], m_halfZ[i]), Vec3(ZERO));
+	center = Vec3(m_centerX[i], m_centerY[i], m_centerZ[i]);
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+CDominoPicker::DominoId CDominoPicker::Pick(const Vec3& origin, const Vec3& direction, float maxDistance, float* pDistance) const
+{
+	float bestDistance = maxDistance;
+	size_t bestIndex = ~size_t(0);
+
+#if defined(DOMINO_PICKER_AVX2) || defined(DOMINO_PICKER_SSE)
+	PickSimd(origin, direction, bestDistance, bestIndex);
+#else
+	PickScalar(0, m_ids.size(), origin, direction, bestDistance, bestIndex);
+#endif
+
+	if (bestIndex >= m_ids.size())
+		return CDominoWorldPartition::InvalidId;
+
+	if (pDistance != nullptr)
+		*pDistance = bestDistance;
+
+	return m_ids[bestIndex];
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoPicker::PickScalar(size_t begin, size_t end, const Vec3& origin, const Vec3& direction, float& bestDistance, size_t& bestIndex) const
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		const Vec3 delta = origin - Vec3(m_centerX[i], m_centerY[i], m_centerZ[i]);
+		const Vec3 axes[3] = {
+			Vec3(m_axisXx[i], m_axisXy[i], m_axisXz[i]),
+			Vec3(m_axisYx[i], m_axisYy[i], m_axisYz[i]),
+			Vec3(m_axisZx[i], m_axisZy[i], m_axisZz[i]) };
+		const float halfSize[3] = { m_halfX[i], m_halfY[i], m_halfZ[i] };
+
+		// Slab test in box space
+		float tNear = 0.f;
+		float tFar = bestDistance;
+		for (int axis = 0; axis < 3 && tNear <= tFar; axis++)
+		{
+			const float localOrigin = delta.Dot(axes[axis]);
+			const float inverseDirection = 1.f / direction.Dot(axes[axis]);
+			const float t1 = (-halfSize[axis] - localOrigin) * inverseDirection;
+			const float t2 = (halfSize[axis] - localOrigin) * inverseDirection;
+			tNear = max(tNear, min(t1, t2));
+			tFar = min(tFar, max(t1, t2));
+		}
+
+		if (tNear <= tFar && tNear < bestDistance)
+		{
+			bestDistance = tNear;
+			bestIndex = i;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoPicker::PickSimd(const Vec3& origin, const Vec3& direction, float& bestDistance, size_t& bestIndex) const
+{
+#if defined(DOMINO_PICKER_AVX2)
+	typedef __m256 Lane;
+	constexpr size_t Width = 8;
+	#define LANE_SET1 _mm256_set1_ps
+	#define LANE_LOAD _mm256_loadu_ps
+	#define LANE_SUB _mm256_sub_ps
+	#define LANE_MUL _mm256_mul_ps
+	#define LANE_DIV _mm256_div_ps
+	// AVX2 doesn't imply FMA, GCC and Clang only accept the intrinsic with -mfma, MSVC always does
+	#if defined(__FMA__) || defined(_MSC_VER)
+		#define LANE_FMADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+	#else
+		#define LANE_FMADD(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+	#endif
+	#define LANE_MIN _mm256_min_ps
+	#define LANE_MAX _mm256_max_ps
+	#define LANE_MASK(tNear, tFar) _mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ))
+	#define LANE_STORE _mm256_storeu_ps
+#elif defined(DOMINO_PICKER_SSE)
+	typedef __m128 Lane;
+	constexpr size_t Width = 4;
+	#define LANE_SET1 _mm_set1_ps
+	#define LANE_LOAD _mm_loadu_ps
+	#define LANE_SUB _mm_sub_ps
+	#define LANE_MUL _mm_mul_ps
+	#define LANE_DIV _mm_div_ps
+	#define LANE_FMADD(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+	#define LANE_MIN _mm_min_ps
+	#define LANE_MAX _mm_max_ps
+	#define LANE_MASK(tNear, tFar) _mm_movemask_ps(_mm_cmple_ps(tNear, tFar))
+	#define LANE_STORE _mm_storeu_ps
+#endif
+
+#if defined(DOMINO_PICKER_AVX2) || defined(DOMINO_PICKER_SSE)
+	const Lane originX = LANE_SET1(origin.x), originY = LANE_SET1(origin.y), originZ = LANE_SET1(origin.z);
+	const Lane directionX = LANE_SET1(direction.x), directionY = LANE_SET1(direction.y), directionZ = LANE_SET1(direction.z);
+	const Lane zero = LANE_SET1(0.f);
+	const Lane one = LANE_SET1(1.f);
+
+	alignas(32) float nearDistances[Width];
+
+	for (size_t i = 0; i < m_ids.size(); i += Width)
+	{
+		const Lane deltaX = LANE_SUB(originX, LANE_LOAD(&m_centerX[i]));
+		const Lane deltaY = LANE_SUB(originY, LANE_LOAD(&m_centerY[i]));
+		const Lane deltaZ = LANE_SUB(originZ, LANE_LOAD(&m_centerZ[i]));
+
+		Lane tNear = zero;
+		Lane tFar = LANE_SET1(bestDistance);
+
+		// One slab per box axis, the ray is moved into box space with three dot products
+		const float* axes[3][3] = {
+			{ &m_axisXx[i], &m_axisXy[i], &m_axisXz[i] },
+			{ &m_axisYx[i], &m_axisYy[i], &m_axisYz[i] },
+			{ &m_axisZx[i], &m_axisZy[i], &m_axisZz[i] } };
+		const float* halfSizes[3] = { &m_halfX[i], &m_halfY[i], &m_halfZ[i] };
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const Lane axisX = LANE_LOAD(axes[axis][0]);
+			const Lane axisY = LANE_LOAD(axes[axis][1]);
+			const Lane axisZ = LANE_LOAD(axes[axis][2]);
+			const Lane halfSize = LANE_LOAD(halfSizes[axis]);
+
+			const Lane localOrigin = LANE_FMADD(deltaZ, axisZ, LANE_FMADD(deltaY, axisY, LANE_MUL(deltaX, axisX)));
+			const Lane localDirection = LANE_FMADD(directionZ, axisZ, LANE_FMADD(directionY, axisY, LANE_MUL(directionX, axisX)));
+			const Lane inverseDirection = LANE_DIV(one, localDirection);
+
+			const Lane t1 = LANE_MUL(LANE_SUB(LANE_SUB(zero, halfSize), localOrigin), inverseDirection);
+			const Lane t2 = LANE_MUL(LANE_SUB(halfSize, localOrigin), inverseDirection);
+			tNear = LANE_MAX(tNear, LANE_MIN(t1, t2));
+			tFar = LANE_MIN(tFar, LANE_MAX(t1, t2));
+		}
+
+		// Hits are rare, resolve the closest one of the block lane by lane
+		int mask = LANE_MASK(tNear, tFar);
+		if (mask == 0)
+			continue;
+
+		LANE_STORE(nearDistances, tNear);
+		for (size_t lane = 0; mask != 0; lane++, mask >>= 1)
+		{
+			if ((mask & 1) != 0 && nearDistances[lane] < bestDistance)
+			{
+				bestDistance = nearDistances[lane];
+				bestIndex = i + lane;
+			}
+		}
+	}
+
+	#undef LANE_SET1
+	#undef LANE_LOAD
+	#undef LANE_SUB
+	#undef LANE_MUL
+	#undef LANE_DIV
+	#undef LANE_FMADD
+	#undef LANE_MIN
+	#undef LANE_MAX
+	#undef LANE_MASK
+	#undef LANE_STORE
+#else
+	PickScalar(0, m_ids.size(), origin, direction, bestDistance, bestIndex);
+#endif
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "DominoWorldPartition.h"
+
+////////////////////////////////////////////////////////
+// Game-side ray picking against the resting dominoes
+// Boxes are kept in structure-of-arrays form and tested 8 at a time with AVX2,
+// 4 at a time with SSE, or one by one, without going through the physics world
+////////////////////////////////////////////////////////
+
+class CDominoPicker
+{
+public:
+	typedef CDominoWorldPartition::DominoId DominoId;
+
+	// Repacks every visible domino's rest box, call after the layout changed
+	void Rebuild(const CDominoWorldPartition& partition);
+	void Clear();
+
+	// Closest domino hit by the ray within maxDistance, InvalidId if none
+	// direction shall be normalized
+	DominoId Pick(const Vec3& origin, const Vec3& direction, float maxDistance, float* pDistance = nullptr) const;
+
+	// Oriented box of a packed domino, for highlighting
+	bool GetBox(DominoId id, OBB& box, Vec3& center) const;
+
+	size_t GetCount() const { return m_ids.size(); }
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	// Boxes are padded to a multiple of this, the padding can never be hit
+	static constexpr size_t BlockSize = 8;
+
+	void PushBox(DominoId id, const Vec3& center, const Matrix33& axes, const Vec3& halfSize);
+
+	// Tests boxes [begin, end) and keeps the closest hit
+	void PickScalar(size_t begin, size_t end, const Vec3& origin, const Vec3& direction, float& bestDistance, size_t& bestIndex) const;
+	void PickSimd(const Vec3& origin, const Vec3& direction, float& bestDistance, size_t& bestIndex) const;
+
+	// Box centres
+	std::vector<float> m_centerX, m_centerY, m_centerZ;
+	// Box axes, rows of the world to box rotation
+	std::vector<float> m_axisXx, m_axisXy, m_axisXz;
+	std::vector<float> m_axisYx, m_axisYy, m_axisYz;
+	std::vector<float> m_axisZx, m_axisZy, m_axisZz;
+	std::vector<float> m_halfX, m_halfY, m_halfZ;
+
+	std::vector<DominoId> m_ids;
+	// Packed index of every domino id, or ~0 when it isn't packed
+	std::vector<uint32> m_indices;
+};
@@ -0,0 +1,1001 @@
+#include "StdAfx.h"
+#include "DominoWorldPartition.h"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------
+
+uint64 CDominoWorldPartition::GetCellKey(const Vec3& position) const
+{
+	const int32 x = (int32)floor_tpl(position.x / m_cellSize);
+	const int32 y = (int32)floor_tpl(position.y / m_cellSize);
+	return ((uint64)(uint32)x << 32) | (uint64)(uint32)y;
+}
+
+//----------------------------------------------------------------------------------
+
+Vec3 CDominoWorldPartition::GetCellCenter(uint64 key) const
+{
+	const int32 x = (int32)(uint32)(key >> 32);
+	const int32 y = (int32)(uint32)(key & 0xFFFFFFFF);
+	return Vec3(((float)x + .5f) * m_cellSize, ((float)y + .5f) * m_cellSize, 0);
+}
+
+//----------------------------------------------------------------------------------
+
+IEntity* CDominoWorldPartition::GetEntity(DominoId id) const
+{
+	if (id >= m_dominoes.size() || m_dominoes[id].entityId == INVALID_ENTITYID)
+		return nullptr;
+
+	return gEnv->pEntitySystem->GetEntity(m_dominoes[id].entityId);
+}
+
+//----------------------------------------------------------------------------------
+
+CDominoWorldPartition::DominoId CDominoWorldPartition::Add(const Vec3& position, const Quat& rotation, EDominoKind kind, bool isSnapped, GroupId group)
+{
+	const DominoId id = (DominoId)m_dominoes.size();
+
+	SDominoRecord record;
+	record.restPosition = record.position = position;
+	record.restRotation = record.rotation = rotation;
+	record.kind = kind;
+	record.group = group;
+	record.cell = GetCellKey(position);
+	for (uint8& pip : record.pips)
+	{
+		pip = (uint8)cry_random(1, DominoAssets::PipValueCount);
+	}
+	m_dominoes.push_back(record);
+	AddToGroup(group, record.cell);
+
+	SCell& cell = m_cells[record.cell];
+	cell.dominoes.push_back(id);
+
+	if (!cell.isActive)
+	{
+		ActivateCell(record.cell, cell, false);
+	}
+	else
+	{
+		// Editing a baked cell brings its pieces back until the next bake
+		if (cell.bakedEntityId != INVALID_ENTITYID)
+			UnbakeCell(cell);
+
+		Materialize(id);
+	}
+
+	// The spawn snaps the piece onto the terrain, keep that as its rest pose
+	if (IEntity* pEntity = GetEntity(id))
+	{
+		if (CDominoComponent* pDomino = pEntity->GetComponent<CDominoComponent>())
+		{
+			if (!isSnapped)
+				pDomino->SnapToTerrain();
+
+			SDominoRecord& placed = m_dominoes[id];
+			placed.restPosition = placed.position = pDomino->m_position;
+			placed.restRotation = placed.rotation = pDomino->m_rotation;
+		}
+	}
+
+	SCell& placedCell = m_cells[m_dominoes[id].cell];
+	placedCell.height += (m_dominoes[id].restPosition.z - placedCell.height) / (float)placedCell.dominoes.size();
+
+	return id;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::AddBatch(const std::vector<SPlacement>& placements, std::vector<DominoId>& ids, GroupId group)
+{
+	ids.reserve(ids.size() + placements.size());
+	m_dominoes.reserve(m_dominoes.size() + placements.size());
+
+	std::vector<uint64> touchedCells;
+
+	for (const SPlacement& placement : placements)
+	{
+		const DominoId id = (DominoId)m_dominoes.size();
+
+		SDominoRecord record;
+		record.restPosition = record.position = placement.transform.t;
+		record.restRotation = record.rotation = placement.transform.q;
+		record.kind = placement.kind;
+		record.group = group;
+		record.cell = GetCellKey(placement.transform.t);
+		if (placement.pips[0] != 0)
+		{
+			record.pips = placement.pips;
+		}
+		else
+		{
+			for (uint8& pip : record.pips)
+			{
+				pip = (uint8)cry_random(1, DominoAssets::PipValueCount);
+			}
+		}
+		m_dominoes.push_back(record);
+		AddToGroup(group, record.cell);
+
+		SCell& cell = m_cells[record.cell];
+		cell.dominoes.push_back(id);
+		cell.height += (placement.transform.t.z - cell.height) / (float)cell.dominoes.size();
+
+		if (std::find(touchedCells.begin(), touchedCells.end(), record.cell) == touchedCells.end())
+			touchedCells.push_back(record.cell);
+
+		ids.push_back(id);
+	}
+
+	// Dormant cells keep the new pieces as data, active ones are refreshed once
+	for (uint64 key : touchedCells)
+	{
+		SCell& cell = m_cells[key];
+		if (!cell.isActive)
+			continue;
+
+		const bool rebake = m_isBakeEnabled && cell.dominoes.size() >= m_minBakeCount;
+
+		if (cell.bakedEntityId != INVALID_ENTITYID)
+			UnbakeCell(cell, !rebake);
+
+		if (!rebake || !BakeCell(key, cell))
+		{
+			for (DominoId id : cell.dominoes)
+			{
+				Materialize(id);
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::Remove(DominoId id)
+{
+	Remove(std::vector<DominoId>(1, id));
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::Remove(const std::vector<DominoId>& ids)
+{
+	// Cells that lost pieces, and whether one of them showed in the cell's chunk
+	std::vector<std::pair<uint64, bool>> touchedCells;
+
+	for (DominoId id : ids)
+	{
+		if (id >= m_dominoes.size() || m_dominoes[id].isRemoved)
+			continue;
+
+		Dematerialize(id);
+
+		SDominoRecord& record = m_dominoes[id];
+		const bool wasVisible = !IsHidden(record);
+		record.isRemoved = true;
+		m_removedCount++;
+
+		auto it = std::find_if(touchedCells.begin(), touchedCells.end(), [&record](const std::pair<uint64, bool>& cell) { return cell.first == record.cell; });
+		if (it == touchedCells.end())
+			touchedCells.emplace_back(record.cell, wasVisible);
+		else
+			it->second |= wasVisible;
+	}
+
+	// Each cell is compacted once, its chunk is only rebuilt if it showed a removed piece
+	for (const std::pair<uint64, bool>& touched : touchedCells)
+	{
+		auto it = m_cells.find(touched.first);
+		if (it == m_cells.end())
+			continue;
+
+		SCell& cell = it->second;
+		cell.dominoes.erase(std::remove_if(cell.dominoes.begin(), cell.dominoes.end(), [this](DominoId id) { return m_dominoes[id].isRemoved; }), cell.dominoes.end());
+
+		if (cell.bakedEntityId == INVALID_ENTITYID || !touched.second)
+			continue;
+
+		UnbakeCell(cell, false);
+		if (cell.dominoes.size() >= m_minBakeCount && BakeCell(touched.first, cell))
+			continue;
+
+		for (DominoId id : cell.dominoes)
+		{
+			Materialize(id);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::SetHidden(DominoId id, bool isHidden)
+{
+	if (id >= m_dominoes.size() || m_dominoes[id].isRemoved)
+		return;
+
+	SDominoRecord& record = m_dominoes[id];
+	if (record.isHidden == isHidden)
+		return;
+
+	record.isHidden = isHidden;
+
+	auto it = m_cells.find(record.cell);
+	if (it != m_cells.end() && it->second.bakedEntityId != INVALID_ENTITYID)
+		UnbakeCell(it->second);
+
+	// Hidden dominoes don't need an entity at all
+	if (isHidden)
+	{
+		Dematerialize(id);
+	}
+	else if (it != m_cells.end() && it->second.isActive)
+	{
+		Materialize(id);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+CDominoWorldPartition::GroupId CDominoWorldPartition::CreateGroup()
+{
+	const GroupId group = (GroupId)m_groups.size();
+	m_groups.emplace_back();
+
+	// Layers outlive Clear, a reused one may still be disabled from an earlier layout
+	const string layer = GetGroupLayerName(group);
+	if (gEnv->pEntitySystem->FindLayer(layer) == nullptr)
+		gEnv->pEntitySystem->AddLayer(layer, nullptr, (uint16)(GroupLayerBaseId + group), true, eSpecType_All, true);
+	else
+		gEnv->pEntitySystem->EnableLayer(layer, true, false);
+
+	return group;
+}
+
+//----------------------------------------------------------------------------------
+
+string CDominoWorldPartition::GetGroupLayerName(GroupId group) const
+{
+	return string().Format("DominoGroup%u", group);
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::AddToGroup(GroupId group, uint64 key)
+{
+	if (group >= m_groups.size())
+		return;
+
+	// Consecutive pieces of a stroke mostly share a cell
+	std::vector<uint64>& cells = m_groups[group].cells;
+	if (cells.empty() || (cells.back() != key && std::find(cells.begin(), cells.end(), key) == cells.end()))
+		cells.push_back(key);
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::SetGroupHidden(GroupId group, bool isHidden)
+{
+	if (group >= m_groups.size() || m_groups[group].isHidden == isHidden)
+		return;
+
+	m_groups[group].isHidden = isHidden;
+
+	// The group's entities hide and drop their physics with their layer
+	gEnv->pEntitySystem->EnableLayer(GetGroupLayerName(group), !isHidden, false);
+
+	// Baked chunks mix groups, those cells are rebaked with or without the group's pieces
+	for (uint64 key : m_groups[group].cells)
+	{
+		auto it = m_cells.find(key);
+		if (it == m_cells.end() || !it->second.isActive || it->second.bakedEntityId == INVALID_ENTITYID)
+			continue;
+
+		SCell& cell = it->second;
+		UnbakeCell(cell, false);
+		if (BakeCell(key, cell))
+			continue;
+
+		for (DominoId id : cell.dominoes)
+		{
+			Materialize(id);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::GatherRestPositions(const Vec3& from, const Vec3& to, float margin, std::vector<Vec3>& positions) const
+{
+	std::vector<DominoId> ids;
+	QueryBox(Vec2(min(from.x, to.x) - margin, min(from.y, to.y) - margin), Vec2(max(from.x, to.x) + margin, max(from.y, to.y) + margin), ids);
+
+	positions.reserve(positions.size() + ids.size());
+	for (DominoId id : ids)
+	{
+		positions.push_back(m_dominoes[id].restPosition);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::QueryBox(const Vec2& minimum, const Vec2& maximum, std::vector<DominoId>& ids) const
+{
+	const int32 minX = (int32)floor_tpl(minimum.x / m_cellSize);
+	const int32 minY = (int32)floor_tpl(minimum.y / m_cellSize);
+	const int32 maxX = (int32)floor_tpl(maximum.x / m_cellSize);
+	const int32 maxY = (int32)floor_tpl(maximum.y / m_cellSize);
+
+	for (int32 x = minX; x <= maxX; x++)
+	{
+		for (int32 y = minY; y <= maxY; y++)
+		{
+			auto it = m_cells.find(((uint64)(uint32)x << 32) | (uint64)(uint32)y);
+			if (it == m_cells.end())
+				continue;
+
+			for (DominoId id : it->second.dominoes)
+			{
+				const SDominoRecord& record = m_dominoes[id];
+				if (IsHidden(record))
+					continue;
+
+				const Vec3& p = record.restPosition;
+				if (p.x >= minimum.x && p.x <= maximum.x && p.y >= minimum.y && p.y <= maximum.y)
+					ids.push_back(id);
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::QueryLasso(const std::vector<Vec2>& lasso, std::vector<DominoId>& ids) const
+{
+	if (lasso.size() < 3)
+		return;
+
+	Vec2 minimum = lasso[0];
+	Vec2 maximum = lasso[0];
+	for (const Vec2& point : lasso)
+	{
+		minimum.x = min(minimum.x, point.x);
+		minimum.y = min(minimum.y, point.y);
+		maximum.x = max(maximum.x, point.x);
+		maximum.y = max(maximum.y, point.y);
+	}
+
+	std::vector<DominoId> candidates;
+	QueryBox(minimum, maximum, candidates);
+
+	for (DominoId id : candidates)
+	{
+		const Vec3& p = m_dominoes[id].restPosition;
+
+		// Even-odd rule
+		bool isInside = false;
+		for (size_t i = 0, j = lasso.size() - 1; i < lasso.size(); j = i++)
+		{
+			const Vec2& a = lasso[i];
+			const Vec2& b = lasso[j];
+			if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)
+				isInside = !isInside;
+		}
+
+		if (isInside)
+			ids.push_back(id);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::Update(const Vec3& focusPosition, bool isSimulating)
+{
+	const Vec3 focus(focusPosition.x, focusPosition.y, 0);
+	// Half diagonal of a cell, so any cell overlapping the radius counts
+	const float cellReach = m_cellSize * 0.7072f;
+	const float activationDistance = m_activationRadius + cellReach;
+	const float releaseDistance = m_activationRadius * m_releaseFactor + cellReach;
+
+	// Cells around the camera
+	const int range = (int)ceil_tpl(m_activationRadius / m_cellSize);
+	for (int dx = -range; dx <= range; dx++)
+	{
+		for (int dy = -range; dy <= range; dy++)
+		{
+			const uint64 key = GetCellKey(focus + Vec3(dx * m_cellSize, dy * m_cellSize, 0));
+			auto it = m_cells.find(key);
+			if (it == m_cells.end() || it->second.isActive)
+				continue;
+
+			if (Distance::Point_Point2D(GetCellCenter(key), focus) <= activationDistance)
+				ActivateCell(key, it->second, true);
+		}
+	}
+
+	// Cells with a recent domino contact are part of the wavefront, keep them and their neighbours in
+	// Contacts come from the shared collision ring, no piece is polled for its sleep state
+	const CDominoCollisions& collisions = CDominoCollisions::Get();
+	std::vector<uint64> wavefrontCells;
+	m_contactCount = 0;
+	if (!isSimulating)
+	{
+		m_contactCursor = collisions.GetCursor();
+	}
+	else
+	{
+		const float time = gEnv->pTimer->GetCurrTime();
+		collisions.Consume(m_contactCursor, [this, time](const CDominoCollisions::SContact& contact)
+			{
+				auto it = m_cells.find(GetCellKey(contact.point));
+				if (it != m_cells.end())
+					it->second.lastContactTime = time;
+
+				m_contactCount++;
+			});
+
+		for (uint64 key : m_activeCells)
+		{
+			if (time - m_cells[key].lastContactTime <= m_wavefrontHoldTime)
+				wavefrontCells.push_back(key);
+		}
+
+		for (uint64 key : wavefrontCells)
+		{
+			const Vec3 center = GetCellCenter(key);
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					const uint64 neighbour = GetCellKey(center + Vec3(dx * m_cellSize, dy * m_cellSize, 0));
+					auto it = m_cells.find(neighbour);
+					if (it != m_cells.end() && !it->second.isActive)
+						ActivateCell(neighbour, it->second, false);
+				}
+			}
+		}
+	}
+
+	// Everything else that drifted out of range goes back to data
+	for (size_t i = m_activeCells.size(); i-- > 0;)
+	{
+		const uint64 key = m_activeCells[i];
+		if (std::find(wavefrontCells.begin(), wavefrontCells.end(), key) != wavefrontCells.end())
+			continue;
+
+		if (Distance::Point_Point2D(GetCellCenter(key), focus) > releaseDistance)
+			DeactivateCell(key, m_cells[key]);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::UpdateLods(const Vec3& cameraPosition)
+{
+	const SDominoCVars& cvars = SDominoCVars::Get();
+	const float halfCell = m_cellSize * .5f;
+
+	m_lodCounts.fill(0);
+
+	for (uint64 key : m_activeCells)
+	{
+		SCell& cell = m_cells[key];
+
+		// Distance to the nearest point of the cell, the whole cell shares one level
+		const Vec3 center = GetCellCenter(key);
+		const Vec3 delta(
+			max(fabs_tpl(cameraPosition.x - center.x) - halfCell, 0.f),
+			max(fabs_tpl(cameraPosition.y - center.y) - halfCell, 0.f),
+			cameraPosition.z - cell.height);
+		const float distance = delta.GetLength();
+
+		CDominoComponent::ELod lod = CDominoComponent::ELod::Full;
+		if (distance > cvars.d_dominoLowLodDistance)
+			lod = CDominoComponent::ELod::Low;
+		else if (distance > cvars.d_dominoPipLodDistance)
+			lod = CDominoComponent::ELod::NoPips;
+
+		m_lodCounts[(size_t)lod] += cell.entityCount;
+
+		// Pieces materialized since take the cell's level on their own, only a change of level visits them
+		if (lod == cell.lod)
+			continue;
+
+		cell.lod = lod;
+		for (DominoId id : cell.dominoes)
+		{
+			if (IEntity* pEntity = GetEntity(id))
+			{
+				if (CDominoComponent* pDomino = pEntity->GetComponent<CDominoComponent>())
+					pDomino->SetLod(lod);
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::ActivateCell(uint64 key, SCell& cell, bool allowBake)
+{
+	cell.isActive = true;
+	m_activeCells.push_back(key);
+
+	if (allowBake && m_isBakeEnabled && cell.dominoes.size() >= m_minBakeCount && BakeCell(key, cell))
+		return;
+
+	for (DominoId id : cell.dominoes)
+	{
+		Materialize(id);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::DeactivateCell(uint64 key, SCell& cell)
+{
+	if (cell.bakedEntityId != INVALID_ENTITYID)
+	{
+		m_baker.Release(cell.bakedEntityId);
+		cell.bakedEntityId = INVALID_ENTITYID;
+		m_bakedCellCount--;
+	}
+
+	for (DominoId id : cell.dominoes)
+	{
+		Dematerialize(id);
+	}
+
+	cell.isActive = false;
+	m_activeCells.erase(std::remove(m_activeCells.begin(), m_activeCells.end(), key), m_activeCells.end());
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::SetBakeEnabled(bool isEnabled)
+{
+	m_isBakeEnabled = isEnabled;
+
+	if (isEnabled)
+		return;
+
+	for (uint64 key : m_activeCells)
+	{
+		SCell& cell = m_cells[key];
+		if (cell.bakedEntityId != INVALID_ENTITYID)
+			UnbakeCell(cell);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::BakeActiveCells()
+{
+	if (!m_isBakeEnabled)
+		return;
+
+	for (uint64 key : m_activeCells)
+	{
+		SCell& cell = m_cells[key];
+		if (cell.bakedEntityId == INVALID_ENTITYID && cell.dominoes.size() >= m_minBakeCount)
+			BakeCell(key, cell);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool CDominoWorldPartition::BakeCell(uint64 key, SCell& cell)
+{
+	std::vector<CDominoChunkBaker::SPiece> pieces;
+	pieces.reserve(cell.dominoes.size());
+
+	for (DominoId id : cell.dominoes)
+	{
+		const SDominoRecord& record = m_dominoes[id];
+		if (IsHidden(record) || record.isRemoved)
+			continue;
+
+		pieces.push_back({ record.restPosition, record.restRotation, CDominoKindRegistry::Get(record.kind).scale, record.pips });
+	}
+
+	if (pieces.size() < m_minBakeCount)
+		return false;
+
+	const Vec3 origin = GetCellCenter(key) + Vec3(0, 0, cell.height);
+	IEntity* pBaked = m_baker.Bake(pieces, origin);
+	if (pBaked == nullptr)
+		return false;
+
+	cell.bakedEntityId = pBaked->GetId();
+	m_bakedCellCount++;
+
+	for (DominoId id : cell.dominoes)
+	{
+		Dematerialize(id);
+	}
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::UnbakeCell(SCell& cell, bool materialize)
+{
+	m_baker.Release(cell.bakedEntityId);
+	cell.bakedEntityId = INVALID_ENTITYID;
+	m_bakedCellCount--;
+
+	if (!cell.isActive || !materialize)
+		return;
+
+	for (DominoId id : cell.dominoes)
+	{
+		Materialize(id);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::Materialize(DominoId id)
+{
+	// Pieces of a hidden group still get an entity, it comes up hidden in the group's layer
+	SDominoRecord& record = m_dominoes[id];
+	if (record.entityId != INVALID_ENTITYID || record.isHidden || record.isRemoved)
+		return;
+
+	if (IEntity* pEntity = AcquireEntity(record))
+	{
+		record.entityId = pEntity->GetId();
+		m_materializedCount++;
+
+		// Pooled entities still carry the level of their last cell
+		auto it = m_cells.find(record.cell);
+		if (it != m_cells.end())
+		{
+			it->second.entityCount++;
+			if (CDominoComponent* pDomino = pEntity->GetComponent<CDominoComponent>())
+				pDomino->SetLod(it->second.lod);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::Dematerialize(DominoId id)
+{
+	SDominoRecord& record = m_dominoes[id];
+	if (record.entityId == INVALID_ENTITYID)
+		return;
+
+	// Keep whatever pose the simulation left it in
+	if (IEntity* pEntity = gEnv->pEntitySystem->GetEntity(record.entityId))
+	{
+		record.position = pEntity->GetWorldPos();
+		record.rotation = pEntity->GetWorldRotation();
+	}
+
+	ReleaseEntity(record.entityId);
+	record.entityId = INVALID_ENTITYID;
+	m_materializedCount--;
+
+	auto it = m_cells.find(record.cell);
+	if (it != m_cells.end())
+		it->second.entityCount--;
+}
+
+//----------------------------------------------------------------------------------
+
+IEntity* CDominoWorldPartition::AcquireEntity(const SDominoRecord& record)
+{
+	IEntity* pEntity = nullptr;
+
+	while (!m_entityPool.empty() && pEntity == nullptr)
+	{
+		pEntity = gEnv->pEntitySystem->GetEntity(m_entityPool.back());
+		m_entityPool.pop_back();
+	}
+
+	if (pEntity != nullptr)
+	{
+		pEntity->Hide(false);
+
+		// Pooled pieces still carry whatever they were last used for
+		if (CDominoComponent* pDomino = pEntity->GetComponent<CDominoComponent>())
+		{
+			pDomino->SetKind(record.kind);
+			pDomino->Place(record.restPosition, record.restRotation);
+			pDomino->m_pips = record.pips;
+			pDomino->ApplyPips();
+		}
+	}
+	else
+	{
+		SEntitySpawnParams spawnParams;
+		spawnParams.pClass = gEnv->pEntitySystem->GetClassRegistry()->GetDefaultClass();
+		spawnParams.vPosition = record.restPosition;
+		spawnParams.qRotation = record.restRotation;
+		spawnParams.vScale = Vec3(CDominoKindRegistry::Get(record.kind).scale);
+
+		pEntity = gEnv->pEntitySystem->SpawnEntity(spawnParams);
+		if (pEntity == nullptr)
+			return nullptr;
+
+		// New pieces get the record's kind and pips once, asleep at the rest pose
+		if (CDominoComponent* pDomino = pEntity->CreateComponentClass<CDominoComponent>())
+			pDomino->Init({ record.kind, record.pips });
+	}
+
+	pEntity->EnablePhysics(m_isPhysicsEnabled);
+
+	if (record.group < m_groups.size())
+	{
+		gEnv->pEntitySystem->AddEntityToLayer(GetGroupLayerName(record.group), pEntity->GetId());
+
+		// Joining a disabled layer doesn't hide the entity by itself
+		if (m_groups[record.group].isHidden)
+		{
+			pEntity->Hide(true);
+			pEntity->EnablePhysics(false);
+		}
+	}
+
+	// Dominoes that were simulated before going dormant come back where they were left
+	if (!record.position.IsEquivalent(record.restPosition) || !Quat::IsEquivalent(record.rotation, record.restRotation))
+	{
+		pEntity->SetPosRotScale(record.position, record.rotation, Vec3(CDominoKindRegistry::Get(record.kind).scale));
+	}
+
+	return pEntity;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::ReleaseEntity(EntityId entityId)
+{
+	IEntity* pEntity = gEnv->pEntitySystem->GetEntity(entityId);
+	if (pEntity == nullptr)
+		return;
+
+	if (m_entityPool.size() < m_maxPooledEntities)
+	{
+		gEnv->pEntitySystem->RemoveEntityFromLayers(entityId);
+		pEntity->Hide(true);
+		pEntity->EnablePhysics(false);
+		m_entityPool.push_back(entityId);
+	}
+	else
+	{
+		gEnv->pEntitySystem->RemoveEntity(entityId);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::SetAwake(bool isAwake)
+{
+	// Woken cells count as contacted, the first contacts of the push are still a step away
+	if (isAwake)
+	{
+		const float time = gEnv->pTimer->GetCurrTime();
+		for (uint64 key : m_activeCells)
+		{
+			m_cells[key].lastContactTime = time;
+		}
+	}
+
+	ForEachMaterialized([isAwake](DominoId, IEntity& entity)
+		{
+			if (IPhysicalEntity* pPhysics = entity.GetPhysics())
+			{
+				pe_action_awake awake;
+				awake.bAwake = isAwake ? 1 : 0;
+				pPhysics->Action(&awake);
+			}
+		});
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::SetPhysicsEnabled(bool isEnabled)
+{
+	m_isPhysicsEnabled = isEnabled;
+
+	ForEachMaterialized([isEnabled](DominoId, IEntity& entity)
+		{
+			entity.EnablePhysics(isEnabled);
+		});
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::SetPose(DominoId id, const Vec3& position, const Quat& rotation)
+{
+	if (id >= m_dominoes.size())
+		return;
+
+	SDominoRecord& record = m_dominoes[id];
+	record.position = position;
+	record.rotation = rotation;
+
+	if (IEntity* pEntity = GetEntity(id))
+	{
+		pEntity->SetPosRotScale(position, rotation, Vec3(CDominoKindRegistry::Get(record.kind).scale));
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::ResetToRest()
+{
+	for (SDominoRecord& record : m_dominoes)
+	{
+		record.position = record.restPosition;
+		record.rotation = record.restRotation;
+	}
+
+	ForEachMaterialized([this](DominoId id, IEntity& entity)
+		{
+			if (CDominoComponent* pDomino = entity.GetComponent<CDominoComponent>())
+			{
+				pDomino->Place(m_dominoes[id].restPosition, m_dominoes[id].restRotation);
+			}
+		});
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::ForEachMaterialized(const std::function<void(DominoId, IEntity&)>& func) const
+{
+	for (uint64 key : m_activeCells)
+	{
+		auto it = m_cells.find(key);
+		if (it == m_cells.end())
+			continue;
+
+		for (DominoId id : it->second.dominoes)
+		{
+			if (IsHidden(m_dominoes[id]))
+				continue;
+
+			if (IEntity* pEntity = GetEntity(id))
+			{
+				func(id, *pEntity);
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddObject(this, sizeof(*this));
+	pSizer->AddContainer(m_dominoes);
+	pSizer->AddContainer(m_activeCells);
+	pSizer->AddContainer(m_entityPool);
+
+	// Buckets and nodes of the cell map, plus each cell's id list
+	pSizer->AddObject(&m_cells, m_cells.bucket_count() * sizeof(void*) + m_cells.size() * (sizeof(std::pair<const uint64, SCell>) + sizeof(void*)));
+	for (const std::pair<const uint64, SCell>& cell : m_cells)
+	{
+		pSizer->AddContainer(cell.second.dominoes);
+	}
+
+	pSizer->AddContainer(m_groups);
+	for (const SGroup& group : m_groups)
+	{
+		pSizer->AddContainer(group.cells);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+CDominoWorldPartition::SMemoryStats CDominoWorldPartition::GetMemoryStats() const
+{
+	SMemoryStats stats;
+
+	// The sizer counts every object once, a fresh one per category keeps them apart
+	auto measure = [](const std::function<void(ICrySizer*)>& func)
+	{
+		ICrySizer* pSizer = gEnv->pSystem->CreateSizer();
+		func(pSizer);
+		const size_t bytes = pSizer->GetTotalSize();
+		pSizer->Release();
+		return bytes;
+	};
+
+	stats.layoutBytes = measure([this](ICrySizer* pSizer)
+		{
+			GetMemoryUsage(pSizer);
+		});
+
+	// Only active cells have entities, dormant records are skipped without being touched
+	auto forEachEntity = [this](const std::function<void(IEntity&)>& func)
+	{
+		for (uint64 key : m_activeCells)
+		{
+			for (DominoId id : m_cells.at(key).dominoes)
+			{
+				const EntityId entityId = m_dominoes[id].entityId;
+				if (IEntity* pEntity = entityId != INVALID_ENTITYID ? gEnv->pEntitySystem->GetEntity(entityId) : nullptr)
+					func(*pEntity);
+			}
+		}
+		for (EntityId entityId : m_entityPool)
+		{
+			if (IEntity* pEntity = gEnv->pEntitySystem->GetEntity(entityId))
+				func(*pEntity);
+		}
+	};
+
+	stats.entityBytes = measure([&forEachEntity](ICrySizer* pSizer)
+		{
+			forEachEntity([pSizer](IEntity& entity)
+				{
+					entity.GetMemoryUsage(pSizer);
+				});
+		});
+
+	stats.physicsBytes = measure([&forEachEntity](ICrySizer* pSizer)
+		{
+			forEachEntity([pSizer](IEntity& entity)
+				{
+					if (IPhysicalEntity* pPhysics = entity.GetPhysics())
+						pPhysics->GetMemoryStatistics(pSizer);
+				});
+		});
+
+	stats.renderBytes = measure([this](ICrySizer* pSizer)
+		{
+			for (const std::pair<const uint64, SCell>& cell : m_cells)
+			{
+				IEntity* pBaked = cell.second.bakedEntityId != INVALID_ENTITYID ? gEnv->pEntitySystem->GetEntity(cell.second.bakedEntityId) : nullptr;
+				if (pBaked == nullptr)
+					continue;
+
+				pBaked->GetMemoryUsage(pSizer);
+				for (int slot = 0; slot < pBaked->GetSlotCount(); slot++)
+				{
+					if (IStatObj* pStatObj = pBaked->GetStatObj(slot))
+						pStatObj->GetMemoryUsage(pSizer);
+				}
+			}
+		});
+
+	return stats;
+}
+
+//----------------------------------------------------------------------------------
+
+void CDominoWorldPartition::Clear()
+{
+	if (gEnv != nullptr && gEnv->pEntitySystem != nullptr)
+	{
+		for (const SDominoRecord& record : m_dominoes)
+		{
+			if (record.entityId != INVALID_ENTITYID)
+				gEnv->pEntitySystem->RemoveEntity(record.entityId);
+		}
+
+		for (EntityId entityId : m_entityPool)
+		{
+			gEnv->pEntitySystem->RemoveEntity(entityId);
+		}
+
+		for (const std::pair<const uint64, SCell>& cell : m_cells)
+		{
+			m_baker.Release(cell.second.bakedEntityId);
+		}
+	}
+
+	m_baker.Clear();
+	m_bakedCellCount = 0;
+
+	m_dominoes.clear();
+	m_cells.clear();
+	m_groups.clear();
+	m_activeCells.clear();
+	m_entityPool.clear();
+	m_materializedCount = 0;
+	m_removedCount = 0;
+}
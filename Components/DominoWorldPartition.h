@@ -0,0 +1,220 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include <CryEntitySystem/IEntitySystem.h>
+
+#include "Domino.h"
+#include "DominoChunkBaker.h"
+#include "DominoCollisions.h"
+
+////////////////////////////////////////////////////////
+// Owns every placed domino as plain data, bucketed in a 2D grid of cells
+// Only cells near the camera or near a running chain get entities,
+// the rest keep their pieces as records with no entity, physics or render node
+////////////////////////////////////////////////////////
+
+class CDominoWorldPartition
+{
+public:
+	typedef uint32 DominoId;
+	static constexpr DominoId InvalidId = ~0u;
+	typedef uint32 GroupId;
+	static constexpr GroupId InvalidGroup = ~0u;
+
+	struct SDominoRecord
+	{
+		// Pose the domino returns to when the simulation is reset
+		Vec3 restPosition = ZERO;
+		Quat restRotation = IDENTITY;
+		// Last known pose, differs from the rest pose once it has been simulated
+		Vec3 position = ZERO;
+		Quat rotation = IDENTITY;
+		std::array<uint8, 4> pips = {{ 1, 1, 1, 1 }};
+		EDominoKind kind = EDominoKind::Standard;
+		// Stroke or paste the domino was placed with
+		GroupId group = InvalidGroup;
+
+		EntityId entityId = INVALID_ENTITYID;
+		uint64 cell = 0;
+		bool isHidden = false;
+		bool isRemoved = false;
+	};
+
+	struct SPlacement
+	{
+		QuatT transform;
+		EDominoKind kind;
+		// All zero rolls random pips, like a freshly drawn piece
+		std::array<uint8, 4> pips = {{ 0, 0, 0, 0 }};
+	};
+
+	struct SMemoryStats
+	{
+		// Records, cells, groups and the entity pool
+		size_t layoutBytes = 0;
+		// Entities of materialized and pooled dominoes
+		size_t entityBytes = 0;
+		// Their physical entities, box proxies included
+		size_t physicsBytes = 0;
+		// Baked chunk entities and their merged meshes
+		size_t renderBytes = 0;
+
+		size_t GetTotal() const { return layoutBytes + entityBytes + physicsBytes + renderBytes; }
+	};
+
+	CDominoWorldPartition() = default;
+	~CDominoWorldPartition() { Clear(); }
+
+	CDominoWorldPartition(const CDominoWorldPartition&) = delete;
+	CDominoWorldPartition& operator=(const CDominoWorldPartition&) = delete;
+
+	// Adds a domino and materializes it straight away, it is being placed in front of the user
+	// Positions that were already dropped onto the terrain skip the snapping raycast
+	DominoId Add(const Vec3& position, const Quat& rotation, EDominoKind kind = EDominoKind::Standard, bool isSnapped = false, GroupId group = InvalidGroup);
+	// Adds many dominoes at once, snapped positions expected
+	// Touched cells are rebaked or materialized once, not per piece
+	void AddBatch(const std::vector<SPlacement>& placements, std::vector<DominoId>& ids, GroupId group = InvalidGroup);
+	void Remove(DominoId id);
+	// Removes many dominoes at once, each touched cell is compacted and rebaked once
+	void Remove(const std::vector<DominoId>& ids);
+	void SetHidden(DominoId id, bool isHidden);
+	bool IsHidden(DominoId id) const { return IsHidden(m_dominoes[id]); }
+
+	// A group holds the pieces of one stroke or paste, so they can be hidden together
+	// Each group has an entity layer its materialized pieces are kept in
+	GroupId CreateGroup();
+	// Toggles the group's layer, only the group's baked cells are visited to be rebaked
+	void SetGroupHidden(GroupId group, bool isHidden);
+	bool IsGroupHidden(GroupId group) const { return group < m_groups.size() && m_groups[group].isHidden; }
+
+	// Returns nullptr while the domino is dormant
+	IEntity* GetEntity(DominoId id) const;
+	const SDominoRecord& GetRecord(DominoId id) const { return m_dominoes[id]; }
+	// Moves a domino without going through physics, its entity follows if it has one
+	void SetPose(DominoId id, const Vec3& position, const Quat& rotation);
+
+	// Appends the rest positions of every visible domino within margin of the segment's 2D bounds
+	void GatherRestPositions(const Vec3& from, const Vec3& to, float margin, std::vector<Vec3>& positions) const;
+
+	// Visible dominoes whose rest position lies in the 2D box, or inside the closed lasso polygon
+	void QueryBox(const Vec2& minimum, const Vec2& maximum, std::vector<DominoId>& ids) const;
+	void QueryLasso(const std::vector<Vec2>& lasso, std::vector<DominoId>& ids) const;
+
+	// Activates cells around the focus point and around recent domino contacts, and turns the others back into data
+	void Update(const Vec3& focusPosition, bool isSimulating);
+	// Domino contacts consumed by the last Update
+	size_t GetContactCount() const { return m_contactCount; }
+
+	// Picks a detail level per active cell from its distance to the camera, see SDominoCVars
+	// Only cells whose level changed touch their pieces
+	void UpdateLods(const Vec3& cameraPosition);
+	size_t GetLodCount(CDominoComponent::ELod lod) const { return m_lodCounts[(size_t)lod]; }
+
+	// While enabled, resting cells are merged into one baked chunk each instead of per-piece entities
+	void SetBakeEnabled(bool isEnabled);
+	// Bakes every active cell that isn't baked yet, call once a stroke or undo is committed
+	void BakeActiveCells();
+	size_t GetBakedCellCount() const { return m_bakedCellCount; }
+
+	void SetAwake(bool isAwake);
+	// Entities materialized while disabled come up without physics as well
+	void SetPhysicsEnabled(bool isEnabled);
+	void ResetToRest();
+	void Clear();
+
+	// Hidden pieces are skipped, their entities stay as their layer left them
+	void ForEachMaterialized(const std::function<void(DominoId, IEntity&)>& func) const;
+
+	size_t GetCount() const { return m_dominoes.size() - m_removedCount; }
+	// Ids run from 0 to GetIdCount() - 1, removed ones included
+	size_t GetIdCount() const { return m_dominoes.size(); }
+	size_t GetMaterializedCount() const { return m_materializedCount; }
+	size_t GetActiveCellCount() const { return m_activeCells.size(); }
+
+	// Plain data only, entities are reported by the entity system
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+	// Measures everything the layout owns, visits the records of the active cells and the entity pool
+	SMemoryStats GetMemoryStats() const;
+
+	float m_cellSize = 16.f;
+	// Cells within this distance of the focus point are materialized
+	float m_activationRadius = 64.f;
+	// Cells are only released past m_activationRadius * m_releaseFactor, avoids churn at the border
+	float m_releaseFactor = 1.25f;
+	// Upper bound of hidden entities kept around for reuse
+	size_t m_maxPooledEntities = 2048;
+	// Cells with fewer pieces than this stay as individual entities
+	size_t m_minBakeCount = 8;
+	// Seconds a cell stays part of the wavefront after its last domino contact
+	float m_wavefrontHoldTime = 2.f;
+
+private:
+	struct SCell
+	{
+		std::vector<DominoId> dominoes;
+		// Average rest height of the cell's dominoes
+		float height = 0.f;
+		// Merged chunk entity standing in for the cell's pieces while baked
+		EntityId bakedEntityId = INVALID_ENTITYID;
+		// Time of the last domino contact inside the cell, see m_wavefrontHoldTime
+		float lastContactTime = -FLT_MAX;
+		// Level every materialized piece of the cell is at, and how many there are
+		CDominoComponent::ELod lod = CDominoComponent::ELod::Full;
+		uint32 entityCount = 0;
+		bool isActive = false;
+	};
+
+	struct SGroup
+	{
+		// Cells the group's pieces were placed in
+		std::vector<uint64> cells;
+		bool isHidden = false;
+	};
+
+	bool IsHidden(const SDominoRecord& record) const { return record.isHidden || IsGroupHidden(record.group); }
+	void AddToGroup(GroupId group, uint64 key);
+	string GetGroupLayerName(GroupId group) const;
+	// Keeps the group layers clear of the ids level layers use
+	static constexpr uint16 GroupLayerBaseId = 0x8000;
+
+	uint64 GetCellKey(const Vec3& position) const;
+	Vec3 GetCellCenter(uint64 key) const;
+
+	// Baking is skipped when the caller needs the pieces as entities right away
+	void ActivateCell(uint64 key, SCell& cell, bool allowBake);
+	void DeactivateCell(uint64 key, SCell& cell);
+
+	// Returns false if the cell was left as it was
+	bool BakeCell(uint64 key, SCell& cell);
+	// Drops the baked chunk, the pieces get entities again unless the caller rebakes the cell
+	void UnbakeCell(SCell& cell, bool materialize = true);
+
+	void Materialize(DominoId id);
+	void Dematerialize(DominoId id);
+
+	IEntity* AcquireEntity(const SDominoRecord& record);
+	void ReleaseEntity(EntityId entityId);
+
+	std::vector<SDominoRecord> m_dominoes;
+	std::unordered_map<uint64, SCell> m_cells;
+	std::vector<SGroup> m_groups;
+	std::vector<uint64> m_activeCells;
+	std::vector<EntityId> m_entityPool;
+
+	CDominoChunkBaker m_baker;
+	bool m_isBakeEnabled = true;
+	bool m_isPhysicsEnabled = true;
+	size_t m_bakedCellCount = 0;
+
+	CDominoCollisions::Cursor m_contactCursor = 0;
+	size_t m_contactCount = 0;
+
+	std::array<size_t, (size_t)CDominoComponent::ELod::Count> m_lodCounts = {};
+
+	size_t m_materializedCount = 0;
+	size_t m_removedCount = 0;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+////////////////////////////////////////////////////////
+// Fixed-capacity single-producer / single-consumer ring
+// Push never allocates, a full ring rejects the value
+////////////////////////////////////////////////////////
+
+template<typename T, size_t CAPACITY>
+class CSpscRing
+{
+	static_assert(CAPACITY > 1 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY shall be a power of two!");
+
+public:
+
+	// Producer side
+	bool Push(const T& value)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		const size_t tail = m_tail.load(std::memory_order_acquire);
+
+		if (head - tail == CAPACITY)
+			return false;
+
+		m_values[head & (CAPACITY - 1)] = value;
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side
+	bool Pop(T& value)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		const size_t head = m_head.load(std::memory_order_acquire);
+
+		if (head == tail)
+			return false;
+
+		value = m_values[tail & (CAPACITY - 1)];
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool IsEmpty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+	static constexpr size_t Capacity() { return CAPACITY; }
+
+private:
+
+	std::array<T, CAPACITY> m_values;
+
+	// Keep producer and consumer cursors on separate cache lines
+	alignas(64) std::atomic<size_t> m_head { 0 };
+	alignas(64) std::atomic<size_t> m_tail { 0 };
+};
+
+////////////////////////////////////////////////////////
+// Input event pushed by the input callbacks and drained in Update
+// Not SInputEvent, CryInput already declares one
+////////////////////////////////////////////////////////
+
+struct SPlayerInputEvent
+{
+	enum class EType : uint8
+	{
+		InputFlag = 0,
+		MouseYaw,
+		MousePitch,
+		Scroll,
+		Look,
+		Select,
+		Simulate,
+		Undo,
+		Redo,
+		SelectModifier,
+		LassoModifier,
+		Copy,
+		Paste,
+		RotateClipboard,
+		Stamp,
+		CycleKind,
+		Replay
+	};
+
+	EType type;
+	// EActionActivationMode of the originating action
+	uint8 activationMode;
+	// Payload for InputFlag events
+	uint8 flags;
+	float value;
+};
+
+static_assert(std::is_trivially_copyable<SPlayerInputEvent>::value, "SPlayerInputEvent shall stay POD!");
+
+using CInputEventQueue = CSpscRing<SPlayerInputEvent, 256>;
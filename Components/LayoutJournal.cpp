@@ -0,0 +1,504 @@
+#include "StdAfx.h"
+#include "LayoutJournal.h"
+
+#include <CryCore/CryCrc32.h>
+
+#if CRY_PLATFORM_WINDOWS
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	// Kind, position and rotation
+	constexpr size_t PieceBytes = 1 + sizeof(float) * 7;
+	// Size and checksum in front of every record
+	constexpr size_t FrameHeaderBytes = sizeof(uint32) * 2;
+
+	void WriteVarint(std::vector<uint8>& data, uint32 value)
+	{
+		while (value >= 0x80)
+		{
+			data.push_back((uint8)(value | 0x80));
+			value >>= 7;
+		}
+		data.push_back((uint8)value);
+	}
+
+	bool ReadVarint(const std::vector<uint8>& data, size_t& offset, uint32& value)
+	{
+		value = 0;
+		for (uint32 shift = 0; offset < data.size() && shift < 32; shift += 7)
+		{
+			const uint8 byte = data[offset++];
+			value |= (uint32)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	void WriteFloats(std::vector<uint8>& data, const float* pValues, size_t count)
+	{
+		const size_t offset = data.size();
+		data.resize(offset + count * sizeof(float));
+		memcpy(&data[offset], pValues, count * sizeof(float));
+	}
+
+	bool ReadFloats(const std::vector<uint8>& data, size_t& offset, float* pValues, size_t count)
+	{
+		if (offset + count * sizeof(float) > data.size())
+			return false;
+
+		memcpy(pValues, &data[offset], count * sizeof(float));
+		offset += count * sizeof(float);
+		return true;
+	}
+
+	bool SyncFile(FILE* pFile)
+	{
+		if (fflush(pFile) != 0)
+			return false;
+
+#if CRY_PLATFORM_WINDOWS
+		return _commit(_fileno(pFile)) == 0;
+#else
+		return fsync(fileno(pFile)) == 0;
+#endif
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool CLayoutJournal::Open(const char* path, SState& state)
+{
+	if (m_isOpen)
+		return false;
+
+	char adjustedPath[ICryPak::g_nMaxPath];
+	m_path = gEnv->pCryPak->AdjustFileName(path, adjustedPath, ICryPak::FLAGS_FOR_WRITING);
+
+	// A compaction that died between removing the journal and renaming its replacement
+	const string tempPath = m_path + ".tmp";
+	if (FILE* pTemp = fopen(tempPath.c_str(), "rb"))
+	{
+		fclose(pTemp);
+		if (FILE* pJournal = fopen(m_path.c_str(), "rb"))
+			fclose(pJournal);
+		else
+			rename(tempPath.c_str(), m_path.c_str());
+	}
+
+	state = SState();
+	m_fileBytes = Recover(state);
+	m_state = state;
+
+	m_pFile = fopen(m_path.c_str(), m_fileBytes > 0 ? "r+b" : "wb");
+	if (m_pFile == nullptr)
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Journal: Can't open %s, the layout won't be saved", m_path.c_str());
+		return false;
+	}
+
+	// Anything past the last intact record is a torn write, the next compaction drops it
+	fseek(m_pFile, 0, SEEK_END);
+	m_needsCompaction = (size_t)ftell(m_pFile) != m_fileBytes;
+	fseek(m_pFile, (long)m_fileBytes, SEEK_SET);
+
+	m_isStopping = false;
+	if (!gEnv->pThreadManager->SpawnThread(this, "DominoJournal"))
+	{
+		fclose(m_pFile);
+		m_pFile = nullptr;
+		return false;
+	}
+
+	m_isOpen = true;
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::Close()
+{
+	if (!m_isOpen)
+		return;
+
+	{
+		CryAutoLock<CryMutex> lock(m_mutex);
+		m_isStopping = true;
+		m_signal.Notify();
+	}
+
+	gEnv->pThreadManager->JoinThread(this, eJM_Join);
+
+	fclose(m_pFile);
+	m_pFile = nullptr;
+	m_isOpen = false;
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::Push(SOperation&& operation)
+{
+	if (!m_isOpen)
+		return;
+
+	CryAutoLock<CryMutex> lock(m_mutex);
+	m_pending.push_back(std::move(operation));
+
+	// Only the first record of a batch wakes the writer, the others wait for its sync
+	if (m_pending.size() == 1)
+		m_signal.Notify();
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::AppendStroke(bool isStroke, std::vector<SPiece>&& pieces)
+{
+	SOperation operation;
+	operation.type = ERecord::Stroke;
+	operation.stroke.isStroke = isStroke;
+	operation.stroke.pieces = std::move(pieces);
+	Push(std::move(operation));
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::AppendUndo()
+{
+	SOperation operation;
+	operation.type = ERecord::Undo;
+	Push(std::move(operation));
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::AppendRedo()
+{
+	SOperation operation;
+	operation.type = ERecord::Redo;
+	Push(std::move(operation));
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::AppendTruncate()
+{
+	SOperation operation;
+	operation.type = ERecord::Truncate;
+	Push(std::move(operation));
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::ThreadEntry()
+{
+	std::vector<SOperation> batch;
+	std::vector<uint8> payload;
+
+	for (;;)
+	{
+		bool isStopping;
+		{
+			CryAutoLock<CryMutex> lock(m_mutex);
+			while (m_pending.empty() && !m_isStopping && !m_needsCompaction)
+			{
+				m_signal.Wait(m_mutex);
+			}
+
+			// Let the batch fill up for one interval, it goes out with a single fsync
+			if (!m_isStopping)
+				m_signal.TimedWait(m_mutex, (uint32)(m_syncInterval * 1000.f));
+
+			batch.swap(m_pending);
+			isStopping = m_isStopping;
+		}
+
+		m_frames.clear();
+		for (const SOperation& operation : batch)
+		{
+			payload.clear();
+			EncodeOperation(payload, operation);
+			AppendFrame(m_frames, payload);
+			Apply(m_state, operation);
+		}
+		batch.clear();
+
+		if (!m_frames.empty())
+		{
+			m_fileBytes += fwrite(m_frames.data(), 1, m_frames.size(), m_pFile);
+			Sync();
+		}
+
+		size_t snapshotBytes = FrameHeaderBytes + 16;
+		for (const SStroke& stroke : m_state.strokes)
+		{
+			snapshotBytes += 8 + stroke.pieces.size() * PieceBytes;
+		}
+
+		if (m_needsCompaction || (m_fileBytes >= m_minCompactBytes && (float)m_fileBytes > (float)snapshotBytes * m_compactRatio))
+			m_needsCompaction = !Compact();
+
+		if (isStopping)
+			break;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::Sync()
+{
+	if (!SyncFile(m_pFile))
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Journal: Failed to sync %s", m_path.c_str());
+}
+
+//----------------------------------------------------------------------------------
+
+bool CLayoutJournal::Compact()
+{
+	std::vector<uint8> payload;
+	EncodeSnapshot(payload, m_state);
+	m_frames.clear();
+	AppendFrame(m_frames, payload);
+
+	// The snapshot is complete and synced before it replaces the journal
+	const string tempPath = m_path + ".tmp";
+	FILE* pTemp = fopen(tempPath.c_str(), "wb");
+	if (pTemp == nullptr)
+		return false;
+
+	const bool isWritten = fwrite(m_frames.data(), 1, m_frames.size(), pTemp) == m_frames.size() && SyncFile(pTemp);
+	fclose(pTemp);
+	if (!isWritten)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	fclose(m_pFile);
+#if CRY_PLATFORM_WINDOWS
+	// rename doesn't replace on Windows, Open picks the snapshot up if we die in between
+	remove(m_path.c_str());
+#endif
+	const bool isRenamed = rename(tempPath.c_str(), m_path.c_str()) == 0;
+
+	m_pFile = fopen(m_path.c_str(), "ab");
+	if (m_pFile == nullptr)
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Journal: Lost %s while compacting", m_path.c_str());
+		// Keep appending somewhere, Open recovers from the snapshot next time
+		m_pFile = fopen(tempPath.c_str(), "ab");
+		return false;
+	}
+
+	fseek(m_pFile, 0, SEEK_END);
+	m_fileBytes = (size_t)ftell(m_pFile);
+	return isRenamed;
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::Apply(SState& state, const SOperation& operation)
+{
+	switch (operation.type)
+	{
+	case ERecord::Stroke:
+		state.strokes.push_back(operation.stroke);
+		break;
+
+	case ERecord::Undo:
+	{
+		const int n = (int)state.strokes.size() - state.undoSteps;
+		if (n < 1)
+			break;
+
+		state.strokes[n - 1].isHidden = true;
+		state.undoSteps++;
+	}
+	break;
+
+	case ERecord::Redo:
+	{
+		if (state.undoSteps == 0)
+			break;
+
+		state.undoSteps--;
+		state.strokes[state.strokes.size() - state.undoSteps - 1].isHidden = false;
+	}
+	break;
+
+	case ERecord::Truncate:
+		state.strokes.resize(state.strokes.size() - state.undoSteps);
+		state.undoSteps = 0;
+		break;
+
+	default:
+		break;
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::EncodeStroke(std::vector<uint8>& data, const SStroke& stroke)
+{
+	data.push_back((stroke.isStroke ? 1 : 0) | (stroke.isHidden ? 2 : 0));
+	WriteVarint(data, (uint32)stroke.pieces.size());
+
+	for (const SPiece& piece : stroke.pieces)
+	{
+		const float values[7] = { piece.position.x, piece.position.y, piece.position.z, piece.rotation.v.x, piece.rotation.v.y, piece.rotation.v.z, piece.rotation.w };
+		data.push_back((uint8)piece.kind);
+		WriteFloats(data, values, 7);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool CLayoutJournal::DecodeStroke(const std::vector<uint8>& data, size_t& offset, SStroke& stroke)
+{
+	uint32 count;
+	if (offset >= data.size())
+		return false;
+
+	const uint8 flags = data[offset++];
+	if (!ReadVarint(data, offset, count) || offset + (size_t)count * PieceBytes > data.size())
+		return false;
+
+	stroke.isStroke = (flags & 1) != 0;
+	stroke.isHidden = (flags & 2) != 0;
+	stroke.pieces.resize(count);
+
+	for (SPiece& piece : stroke.pieces)
+	{
+		float values[7];
+		piece.kind = (EDominoKind)min<uint8>(data[offset++], (uint8)EDominoKind::Count - 1);
+		ReadFloats(data, offset, values, 7);
+
+		piece.position = Vec3(values[0], values[1], values[2]);
+		piece.rotation = Quat(values[6], values[3], values[4], values[5]);
+	}
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::EncodeOperation(std::vector<uint8>& data, const SOperation& operation)
+{
+	data.push_back((uint8)operation.type);
+	if (operation.type == ERecord::Stroke)
+		EncodeStroke(data, operation.stroke);
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::EncodeSnapshot(std::vector<uint8>& data, const SState& state)
+{
+	data.push_back((uint8)ERecord::Snapshot);
+	WriteVarint(data, (uint32)state.undoSteps);
+	WriteVarint(data, (uint32)state.strokes.size());
+
+	for (const SStroke& stroke : state.strokes)
+	{
+		EncodeStroke(data, stroke);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CLayoutJournal::AppendFrame(std::vector<uint8>& frames, const std::vector<uint8>& payload)
+{
+	const uint32 header[2] = { (uint32)payload.size(), CCrc32::Compute(payload.data(), payload.size()) };
+
+	const size_t offset = frames.size();
+	frames.resize(offset + FrameHeaderBytes + payload.size());
+	memcpy(&frames[offset], header, FrameHeaderBytes);
+	memcpy(&frames[offset + FrameHeaderBytes], payload.data(), payload.size());
+}
+
+//----------------------------------------------------------------------------------
+
+size_t CLayoutJournal::Recover(SState& state)
+{
+	FILE* pFile = fopen(m_path.c_str(), "rb");
+	if (pFile == nullptr)
+		return 0;
+
+	std::vector<uint8> data;
+	fseek(pFile, 0, SEEK_END);
+	data.resize((size_t)max(ftell(pFile), 0L));
+	fseek(pFile, 0, SEEK_SET);
+	data.resize(fread(data.data(), 1, data.size(), pFile));
+	fclose(pFile);
+
+	size_t offset = 0;
+	size_t recordCount = 0;
+	std::vector<uint8> payload;
+
+	while (offset + FrameHeaderBytes <= data.size())
+	{
+		uint32 header[2];
+		memcpy(header, &data[offset], FrameHeaderBytes);
+
+		const size_t end = offset + FrameHeaderBytes + header[0];
+		if (header[0] == 0 || end > data.size() || CCrc32::Compute(&data[offset + FrameHeaderBytes], header[0]) != header[1])
+			break;
+
+		payload.assign(data.begin() + offset + FrameHeaderBytes, data.begin() + end);
+		size_t payloadOffset = 1;
+
+		SOperation operation;
+		operation.type = (ERecord)payload[0];
+
+		bool isValid = true;
+		switch (operation.type)
+		{
+		case ERecord::Stroke:
+			isValid = DecodeStroke(payload, payloadOffset, operation.stroke);
+			break;
+
+		case ERecord::Undo:
+		case ERecord::Redo:
+		case ERecord::Truncate:
+			break;
+
+		case ERecord::Snapshot:
+		{
+			uint32 undoSteps, strokeCount;
+			SState snapshot;
+			isValid = ReadVarint(payload, payloadOffset, undoSteps) && ReadVarint(payload, payloadOffset, strokeCount);
+			for (uint32 i = 0; isValid && i < strokeCount; i++)
+			{
+				snapshot.strokes.emplace_back();
+				isValid = DecodeStroke(payload, payloadOffset, snapshot.strokes.back());
+			}
+
+			snapshot.undoSteps = (int)min(undoSteps, (uint32)snapshot.strokes.size());
+			if (isValid)
+				state = std::move(snapshot);
+		}
+		break;
+
+		default:
+			isValid = false;
+			break;
+		}
+
+		if (!isValid)
+			break;
+
+		if (operation.type != ERecord::Snapshot)
+			Apply(state, operation);
+
+		offset = end;
+		recordCount++;
+	}
+
+	if (offset < data.size())
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Journal: Dropped %d torn bytes at the end of %s", (int)(data.size() - offset), m_path.c_str());
+
+	CryLog("Journal: Recovered %d strokes from %d records", (int)state.strokes.size(), (int)recordCount);
+	return offset;
+}
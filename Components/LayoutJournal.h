@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+
+#include <CryThreading/IThreadManager.h>
+
+#include "DominoKind.h"
+
+////////////////////////////////////////////////////////
+// Append-only autosave of the layout history
+// Every committed stroke, paste, undo, redo and dropped redo tail is handed to a
+// writer thread as one record. Records that arrive within m_syncInterval share one
+// write and one fsync.
+// The writer keeps its own copy of the history and rewrites the journal as a single
+// snapshot once it grows past m_compactRatio times that size. Open replays whatever
+// made it to disk and stops at the first torn record
+////////////////////////////////////////////////////////
+
+class CLayoutJournal : public IThread
+{
+public:
+	struct SPiece
+	{
+		Vec3 position;
+		Quat rotation;
+		EDominoKind kind;
+	};
+
+	struct SStroke
+	{
+		// Strokes keep their placement order, pastes don't, see CPlayerComponent::SHistorySet
+		bool isStroke = true;
+		bool isHidden = false;
+		std::vector<SPiece> pieces;
+	};
+
+	// The history as CPlayerComponent keeps it
+	struct SState
+	{
+		std::vector<SStroke> strokes;
+		int undoSteps = 0;
+	};
+
+	~CLayoutJournal() { Close(); }
+
+	// Recovers the journal at path into state and starts the writer thread
+	// path goes through ICryPak aliases, %USER% included
+	bool Open(const char* path, SState& state);
+	// Writes out and syncs every pending record, then stops the writer thread
+	void Close();
+	bool IsOpen() const { return m_isOpen; }
+
+	// Cheap on the calling thread, the record is encoded and written by the writer thread
+	void AppendStroke(bool isStroke, std::vector<SPiece>&& pieces);
+	void AppendUndo();
+	void AppendRedo();
+	// Drops the undone strokes, see CPlayerComponent::RestartHistory
+	void AppendTruncate();
+
+	// Seconds records may wait for their fsync, more records in that window share it
+	float m_syncInterval = .5f;
+	// The journal is never compacted below this size
+	size_t m_minCompactBytes = 256 << 10;
+	// Compacts once the journal is this many times larger than a snapshot of the history
+	float m_compactRatio = 2.f;
+
+private:
+	enum class ERecord : uint8
+	{
+		Stroke = 1,
+		Undo,
+		Redo,
+		// The whole history, always the first record of a compacted journal
+		Snapshot,
+		Truncate
+	};
+
+	struct SOperation
+	{
+		ERecord type;
+		SStroke stroke;
+	};
+
+	// IThread
+	virtual void ThreadEntry() override;
+	// ~IThread
+
+	void Push(SOperation&& operation);
+
+	// Mirrors CPlayerComponent::InsertHistorySet, Undo, Redo and RestartHistory
+	static void Apply(SState& state, const SOperation& operation);
+
+	static void EncodeStroke(std::vector<uint8>& data, const SStroke& stroke);
+	static bool DecodeStroke(const std::vector<uint8>& data, size_t& offset, SStroke& stroke);
+	static void EncodeOperation(std::vector<uint8>& data, const SOperation& operation);
+	static void EncodeSnapshot(std::vector<uint8>& data, const SState& state);
+	// Appends payload behind its size and checksum
+	static void AppendFrame(std::vector<uint8>& frames, const std::vector<uint8>& payload);
+
+	// Reads every intact record, returns the byte count they span
+	size_t Recover(SState& state);
+	// Writer thread only
+	bool Compact();
+	void Sync();
+
+	string m_path;
+	FILE* m_pFile = nullptr;
+	size_t m_fileBytes = 0;
+	bool m_isOpen = false;
+
+	CryMutex m_mutex;
+	CryConditionVariable m_signal;
+	std::vector<SOperation> m_pending;
+	bool m_isStopping = false;
+
+	// Writer thread only
+	SState m_state;
+	std::vector<uint8> m_frames;
+	bool m_needsCompaction = false;
+};
@@ -0,0 +1,81 @@
+#include "StdAfx.h"
+#include "PlacementPipeline.h"
+
+//----------------------------------------------------------------------------------
+
+bool CPlacementPipeline::Submit(SSegment&& segment)
+{
+	if (IsBusy() || m_hasResults)
+		return false;
+
+	m_segment = std::move(segment);
+
+	gEnv->pJobManager->AddLambdaJob("DominoPlacement", [this]()
+		{
+			Compute();
+		}, JobManager::eRegularPriority, &m_jobState);
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+bool CPlacementPipeline::Collect(std::vector<SCandidate>& candidates, Vec3& end)
+{
+	if (IsBusy() || !m_hasResults)
+		return false;
+
+	candidates.swap(m_results);
+	m_results.clear();
+	end = m_resultEnd;
+	m_hasResults = false;
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlacementPipeline::Compute()
+{
+	// Runs on a worker, only touches m_segment, m_results and read-only engine queries
+	m_results.clear();
+
+	const float spacing = m_segment.spacing;
+	const float minDistanceSq = sqr(spacing * m_overlapFactor);
+
+	Vec3 previous = m_segment.from;
+
+	while (m_results.size() < m_maxCandidates)
+	{
+		Vec3 dir = m_segment.to - previous;
+		dir.z = 0;
+
+		if (dir.GetLengthSquared() <= sqr(spacing))
+			break;
+
+		dir.Normalize();
+
+		Vec3 position = previous + dir * spacing;
+		position.z = gEnv->p3DEngine->GetTerrainElevation(position.x, position.y);
+
+		bool isAccepted = fabs_tpl(position.z - previous.z) <= m_maxStepHeight;
+
+		for (const Vec3& occupied : m_segment.occupied)
+		{
+			if (!isAccepted)
+				break;
+
+			isAccepted = Vec2(position - occupied).GetLength2() >= minDistanceSq;
+		}
+
+		// A rejected candidate still advances the stroke, the gap is visible to the user
+		if (isAccepted)
+		{
+			m_results.push_back({ position, Quat::CreateRotationVDir(dir) });
+		}
+
+		previous = position;
+	}
+
+	m_resultEnd = previous;
+	m_hasResults = true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include <CryThreading/IJobManager.h>
+
+////////////////////////////////////////////////////////
+// Two-stage stroke placement
+// A job lays out, snaps and validates candidate dominoes along the current stroke segment,
+// the main thread later commits the accepted ones in one batch
+////////////////////////////////////////////////////////
+
+class CPlacementPipeline
+{
+public:
+	struct SSegment
+	{
+		// Last committed domino, the segment continues from it
+		Vec3 from = ZERO;
+		Vec3 to = ZERO;
+		float spacing = .3f;
+		// Positions of nearby existing dominoes, candidates closer than spacing * overlapFactor are rejected
+		std::vector<Vec3> occupied;
+	};
+
+	struct SCandidate
+	{
+		Vec3 position;
+		Quat rotation;
+	};
+
+	~CPlacementPipeline() { Wait(); }
+
+	// Returns false while the previous segment is still being computed
+	bool Submit(SSegment&& segment);
+	// Hands over the accepted candidates of a finished segment and where the stroke got to,
+	// returns false while nothing is ready
+	bool Collect(std::vector<SCandidate>& candidates, Vec3& end);
+
+	bool IsBusy() const { return m_jobState.IsRunning(); }
+	void Wait() { m_jobState.Wait(); }
+
+	// Upper bound of candidates per segment, keeps a single job short
+	size_t m_maxCandidates = 256;
+	float m_overlapFactor = .5f;
+	// Steeper steps than this between two pieces are rejected, the chain could not carry over them
+	float m_maxStepHeight = .15f;
+
+private:
+	void Compute();
+
+	JobManager::SJobState m_jobState;
+	SSegment m_segment;
+	std::vector<SCandidate> m_results;
+	Vec3 m_resultEnd = ZERO;
+	bool m_hasResults = false;
+};
@@ -9,6 +9,10 @@
 #include <CryCore/StaticInstanceList.h>
 #include <CryNetwork/Rmi.h>
 #include "Domino.h"
+#include "DebugDraw.h"
+#include "DominoAssetPrefetch.h"
+
+#include <algorithm>
 
 namespace
 {
@@ -28,7 +32,6 @@ namespace
 
 void CPlayerComponent::Initialize()
 {
-	History.begin();
 	History.clear();
 	CryLog("Player: Initialize");
 	// Mark the entity to be replicated over the network
@@ -40,6 +43,8 @@ void CPlayerComponent::Initialize()
 	SRmi<RMI_WRAP(&CPlayerComponent::RemoteReviveOnClient)>::Register(this, eRAT_NoAttach, false, eNRT_ReliableOrdered);
 
 	m_cameraDesiredGoalPosition = m_cameraCurrentGoalPosition = GetEntity()->GetWorldPos();
+	m_cameraGoalSpring.Reset(m_cameraCurrentGoalPosition);
+	m_zoomSpring.Reset(m_currViewDistance);
 }
 
 //----------------------------------------------------------------------------------
@@ -95,23 +100,74 @@ void CPlayerComponent::ProcessEvent(const SEntityEvent& event)
 
 		if (IsLocalClient())
 		{
+			// Recovering spawns the saved layout, wait until that no longer loads assets on the main thread
+			if (!m_isJournalRecovered && CDominoAssetPrefetch::Get().IsReady())
+				RecoverJournal();
+
+			ProcessInputEvents();
+
 			UpdateZoom(frameTime);
 			UpdateCameraTargetGoal(frameTime);
 
 			if (!m_isSimulating)
 				UpdateCursorPointer();
 
+			if (!m_isSimulating && !m_isReplaying)
+				UpdateHoveredDomino();
+			else
+				m_hoveredDomino = CDominoWorldPartition::InvalidId;
+
+			if (m_isSelecting)
+				UpdateSelection();
+
+			if (!m_isSimulating)
+			{
+				if (m_isChainAnalysisDirty)
+					AnalyzeChains();
+
+				m_chainAnalyzer.Draw(Dominoes);
+				m_telemetry.Draw();
+			}
+
 			UpdateTacticalViewDirection(frameTime);
+
+			if (m_isSimulating)
+			{
+				m_islands.Update(Dominoes);
+				m_telemetry.Update(Dominoes, frameTime);
+				m_replay.Record(Dominoes, frameTime);
+			}
+			else if (m_isReplaying && !m_replay.Play(Dominoes, frameTime))
+				EndReplay();
+
+			// Stream domino cells in and out around the camera goal and any running chain
+			Dominoes.Update(m_cameraCurrentGoalPosition, m_isSimulating);
+			// The camera component carries the audio listener, so its view position is where the clicks are heard
+			const Vec3 viewPosition = GetISystem()->GetViewCamera().GetPosition();
+			Dominoes.UpdateLods(viewPosition);
+			m_audio.Update(viewPosition, frameTime);
+
+			m_frameTimeStats.Push(frameTime);
 			debug->Add2DText(ToString(m_placedDominoes), 2, Col_Green, frameTime);
+			UpdateMemoryStats(frameTime);
+			DrawStats();
 			UpdateCamera(frameTime);
 
-			if (m_placementActive)
+			if (m_isStrokeReleased)
+			{
+				FinishStroke();
+			}
+			else if (m_placementActive)
 			{
-				if(m_ghostFirstDomino)
+				if (m_strokePreview.HasCursor())
 					UpdateFirstGhost(frameTime);
 				
 				UpdatePlacementPosition(GetPositionFromPointer(), frameTime);
 			}
+			m_strokePreview.Update();
+
+			// Everything debug drawn this frame goes out in one batch
+			DOMINO_DEBUG_FLUSH();
 		}
 
 
@@ -121,6 +177,157 @@ void CPlayerComponent::ProcessEvent(const SEntityEvent& event)
 }
 //----------------------------------------------------------------------------------
 
+void CPlayerComponent::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddObject(this, sizeof(*this));
+
+	Dominoes.GetMemoryUsage(pSizer);
+	m_picker.GetMemoryUsage(pSizer);
+	m_replay.GetMemoryUsage(pSizer);
+	m_islands.GetMemoryUsage(pSizer);
+	m_telemetry.GetMemoryUsage(pSizer);
+
+	pSizer->AddContainer(History);
+	for (const std::unique_ptr<SHistorySet>& pHistorySet : History)
+	{
+		pSizer->AddObject(pHistorySet.get(), sizeof(SHistorySet));
+		pSizer->AddContainer(pHistorySet->Dominoes);
+	}
+
+	if (m_ActiveHistory != nullptr)
+	{
+		pSizer->AddObject(m_ActiveHistory.get(), sizeof(SHistorySet));
+		pSizer->AddContainer(m_ActiveHistory->Dominoes);
+	}
+
+	pSizer->AddContainer(m_placementCandidates);
+	pSizer->AddContainer(m_pendingStroke);
+	pSizer->AddContainer(m_lasso);
+	pSizer->AddContainer(m_selection);
+	pSizer->AddContainer(m_clipboard);
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::UpdateMemoryStats(float frameTime)
+{
+	// Walking the layout isn't free, skip it unless someone reads the result
+	bool isNeeded = SDominoCVars::Get().d_dominoMemoryBudget > 0.f;
+#if DOMINO_DEBUG_DRAW
+	isNeeded |= CDebugDraw::IsEnabled(CDebugDraw::ELevel::Basic);
+#endif
+	if (!isNeeded)
+		return;
+
+	m_memoryStatsAge += frameTime;
+	if (m_memoryStatsAge >= 1.f)
+		MeasureMemory();
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::MeasureMemory()
+{
+	m_memoryStatsAge = 0;
+	m_memoryStats = Dominoes.GetMemoryStats();
+	m_memoryStatsCount = Dominoes.GetCount();
+	m_isMemoryMeasured = true;
+
+	m_historyBytes = History.capacity() * sizeof(std::unique_ptr<SHistorySet>);
+	for (const std::unique_ptr<SHistorySet>& pHistorySet : History)
+	{
+		m_historyBytes += sizeof(SHistorySet) + pHistorySet->Dominoes.capacity() * sizeof(CDominoWorldPartition::DominoId);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::DrawStats()
+{
+#if DOMINO_DEBUG_DRAW
+	// None of the strings are built unless the overlay is on
+	if (!CDebugDraw::IsEnabled(CDebugDraw::ELevel::Basic))
+		return;
+
+	// Below the run summary of CChainTelemetry::Draw
+	const float x = 10.f;
+	float y = 270.f;
+
+	DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Basic, x, y, Col_Green, ("Dominoes " + ToString((int)Dominoes.GetMaterializedCount()) + "/" + ToString((int)Dominoes.GetCount())
+		+ " baked cells " + ToString((int)Dominoes.GetBakedCellCount())
+		+ " LOD full " + ToString((int)Dominoes.GetLodCount(CDominoComponent::ELod::Full))
+		+ " no pips " + ToString((int)Dominoes.GetLodCount(CDominoComponent::ELod::NoPips))
+		+ " low " + ToString((int)Dominoes.GetLodCount(CDominoComponent::ELod::Low))).c_str());
+
+	if (m_isSimulating)
+	{
+		DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Basic, x, y += 14.f, Col_Green, ("Contacts " + ToString((int)Dominoes.GetContactCount())
+			+ " heard " + ToString((int)m_audio.GetHeardCount())
+			+ " culled " + ToString((int)m_audio.GetCulledCount())
+			+ " voices " + ToString((int)m_audio.GetActiveVoiceCount())).c_str());
+		DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Basic, x, y += 14.f, Col_Green, ("Islands " + ToString((int)m_islands.GetLiveCount()) + "/" + ToString((int)m_islands.GetCount())
+			+ " largest " + ToString((int)m_islands.GetLargestSize())).c_str());
+	}
+
+	const size_t count = Dominoes.GetCount();
+	const size_t total = GetMemoryTotal();
+	DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Basic, x, y += 14.f, Col_Green, ("Memory " + ToString((int)(total >> 10)) + " KB"
+		+ " (layout " + ToString((int)(m_memoryStats.layoutBytes >> 10))
+		+ " entities " + ToString((int)(m_memoryStats.entityBytes >> 10))
+		+ " physics " + ToString((int)(m_memoryStats.physicsBytes >> 10))
+		+ " render " + ToString((int)(m_memoryStats.renderBytes >> 10))
+		+ " history " + ToString((int)(m_historyBytes >> 10)) + ")"
+		+ " " + ToString(count > 0 ? (int)(total / count) : 0) + " B/domino").c_str());
+
+	if (m_replay.HasRecording())
+		DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Basic, x, y += 14.f, Col_Green, ("Replay " + ToString(m_replay.GetDuration()) + " s " + ToString((int)(m_replay.GetByteCount() >> 10)) + " KB").c_str());
+
+	DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Basic, x, y += 14.f, Col_Green, ("Frame ms avg " + ToString(m_frameTimeStats.Mean() * 1000.f)
+		+ " p95 " + ToString(m_frameTimeStats.Percentile(.95f) * 1000.f)
+		+ " max " + ToString(m_frameTimeStats.Max() * 1000.f)).c_str());
+#endif
+}
+
+//----------------------------------------------------------------------------------
+
+bool CPlayerComponent::CheckMemoryBudget(size_t additionalDominoes)
+{
+	const SDominoCVars& cvars = SDominoCVars::Get();
+	if (cvars.d_dominoMemoryBudget <= 0.f)
+		return true;
+
+	// The sample is up to a second old, it is only taken here if there is none yet or it predates the first piece
+	const size_t count = Dominoes.GetCount();
+	if (!m_isMemoryMeasured || (m_memoryStatsCount == 0 && count > 0))
+		MeasureMemory();
+
+	// Pieces added or removed since the sample and the ones still to be placed cost what the sampled ones did on average
+	const size_t total = GetMemoryTotal();
+	const size_t perDomino = m_memoryStatsCount > 0 ? total / m_memoryStatsCount : 0;
+	const ptrdiff_t change = (ptrdiff_t)count - (ptrdiff_t)m_memoryStatsCount + (ptrdiff_t)additionalDominoes;
+	const size_t projected = (size_t)max((ptrdiff_t)0, (ptrdiff_t)total + (ptrdiff_t)perDomino * change);
+	const size_t budget = (size_t)(cvars.d_dominoMemoryBudget * 1024.f * 1024.f);
+
+	if (projected <= budget)
+	{
+		m_isBudgetWarned = false;
+		return true;
+	}
+
+	const bool isRefused = cvars.d_dominoMemoryBudgetRefuse != 0;
+	if (!isRefused && m_isBudgetWarned)
+		return true;
+
+	m_isBudgetWarned = true;
+	CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Domino layout at %d KB is past the %d KB budget%s",
+		(int)(projected >> 10), (int)(budget >> 10), isRefused ? ", placement refused" : "");
+	debug->Add2DText(isRefused ? "Domino memory budget reached" : "Domino memory budget exceeded", 2, Col_Red, 2);
+
+	return !isRefused;
+}
+
+//----------------------------------------------------------------------------------
+
 void CPlayerComponent::OnReadyForGameplayOnServer()
 {
 	CryLog("Player: Ready for gameplay server");
@@ -202,77 +409,131 @@ void CPlayerComponent::PlaceDomino(Vec3 pos, Quat rot)
 
 
 	m_placedDominoes++;
-	SEntitySpawnParams spawnParams;
-	spawnParams.pClass = gEnv->pEntitySystem->GetClassRegistry()->GetDefaultClass();
-
-	spawnParams.vPosition = pos;
-	
 
 	Vec3 dir = pos - m_lastPlacedPosition;
 	dir.z = 0;
 	
-	if (!m_firstPlaced)
-		spawnParams.qRotation =rot;
-	else
-	spawnParams.qRotation = Quat::CreateRotationVDir(dir);
+	const Quat rotation = m_firstPlaced ? Quat::CreateRotationVDir(dir) : rot;
 
-	// Spawn the entity
-	if (IEntity* pEntity = gEnv->pEntitySystem->SpawnEntity(spawnParams))
-	{
-		pEntity->CreateComponentClass<CDominoComponent>();
-		//auto e = pEntity->CreateComponentClass<CDominoComponent>();
-		
-		//Vec3 m_position = e->GetEntity()->GetWorldPos();
-	//	Quat m_rotation = e->GetEntity()->GetWorldRotation();
-		Dominoes.push_back(pEntity);
-		m_ActiveHistory->Dominoes.push_back(pEntity);
-	}
+	// Stands on the terrain as a spawned piece would after snapping, the partition only sees it on release
+	AddPendingPiece(Vec3(pos.x, pos.y, gEnv->p3DEngine->GetTerrainElevation(pos.x, pos.y)), rotation);
 
-		m_lastPlacedPosition = pos;
+	m_lastPlacedPosition = pos;
+}
 
-		
+void CPlayerComponent::AddPendingPiece(const Vec3& position, const Quat& rotation)
+{
+	m_pendingStroke.push_back({ QuatT(rotation, position), m_placementKind });
+	m_strokePreview.Add(position, rotation, m_placementKind);
+}
+
+void CPlayerComponent::CommitPendingStroke()
+{
+	if (m_ActiveHistory != nullptr && !m_pendingStroke.empty())
+		Dominoes.AddBatch(m_pendingStroke, m_ActiveHistory->Dominoes, m_ActiveHistory->m_group);
+
+	m_pendingStroke.clear();
+	m_strokePreview.Clear();
 }
 
 void CPlayerComponent::BeginSimulation() {
-	for (IEntity* pDom : Dominoes) {		
-		pe_action_awake awake;
-		awake.bAwake = 1;
-		pDom->GetPhysics()->Action(&awake);
-	}
+	if (m_isReplaying)
+		EndReplay();
+
+	// Baked chunks have no physics, bring the individual pieces back first
+	Dominoes.SetBakeEnabled(false);
+	m_replay.BeginRecording(Dominoes);
+	m_islands.Build(Dominoes);
+	m_islands.Begin();
+	if (SDominoCVars::Get().d_dominoTelemetry > 0)
+		m_telemetry.Begin(Dominoes);
+	Dominoes.SetAwake(true);
 	m_isSimulating = true;
 }
 
 void CPlayerComponent::EndSimulation() {
-	ResetDominoes();
-	for (IEntity* pDom : Dominoes) {
-		pe_action_awake awake;
-		awake.bAwake = 0;
-		pDom->GetPhysics()->Action(&awake);
+	m_replay.EndRecording();
+	m_islands.Clear();
+
+	if (m_telemetry.IsRecording())
+	{
+		m_telemetry.End(Dominoes);
+
+		if (SDominoCVars::Get().d_dominoTelemetry > 1)
+		{
+			const bool isExported = m_telemetry.ExportCsv(Dominoes, "%USER%/DominoTelemetry/run.csv")
+				&& m_telemetry.ExportJson("%USER%/DominoTelemetry/run.json");
+			CryLogAlways("Telemetry: %s %%USER%%/DominoTelemetry/run.csv and run.json", isExported ? "Wrote" : "Failed to write");
+		}
 	}
+
+	ResetDominoes();
+	Dominoes.SetAwake(false);
+	Dominoes.SetBakeEnabled(true);
+	Dominoes.BakeActiveCells();
 	m_isSimulating = false;
 }
 
 void CPlayerComponent::ResetDominoes() {
-	for (IEntity* pDom : Dominoes) {
-		CDominoComponent* dom = pDom->GetComponent<CDominoComponent>();
-		pDom->SetPosRotScale(dom->m_position, dom->m_rotation, Vec3(1));
-	}
+	Dominoes.ResetToRest();
 }
 
-void CPlayerComponent::RemoveDomino(IEntity* Domino)
-{
-
+void CPlayerComponent::BeginReplay() {
+	if (m_isSimulating || m_placementActive || !m_replay.HasRecording())
+		return;
 
-	gEnv->pEntitySystem->RemoveEntity(Domino->GetId());
-	Dominoes.shrink_to_fit();
+	// Pieces are moved kinematically, physics stays off for the whole replay
+	Dominoes.SetBakeEnabled(false);
+	Dominoes.SetPhysicsEnabled(false);
+	m_replay.Seek(Dominoes, 0.f);
+	m_isReplaying = true;
+}
 
+void CPlayerComponent::EndReplay() {
+	ResetDominoes();
+	Dominoes.SetPhysicsEnabled(true);
+	Dominoes.SetAwake(false);
+	Dominoes.SetBakeEnabled(true);
+	Dominoes.BakeActiveCells();
+	m_isReplaying = false;
+}
 
+void CPlayerComponent::RemoveDomino(CDominoWorldPartition::DominoId Domino)
+{
+	Dominoes.Remove(Domino);
 }
 
-void CPlayerComponent::InsertHistorySet(SHistorySet* historySet)
+void CPlayerComponent::InsertHistorySet(std::unique_ptr<SHistorySet> historySet)
 {
+	// A click or a refused stroke placed nothing, keep the redo steps and the journal as they are
+	if (historySet->Dominoes.empty())
+		return;
+
+	m_isChainAnalysisDirty = true;
+	m_isPickerDirty = true;
+	// The recording no longer matches the layout
+	m_replay.Clear();
+
+	// A new set after undoing drops the undone ones, they can't be redone past it
+	if (m_undoSteps > 0)
+		RestartHistory(History.size() - m_undoSteps);
+	historySet->m_index = History.size() + 1;
+
 	debug->Add2DText("Added history set "+ ToString(historySet->m_index), 2, Col_White, 2);
-	History.push_back(historySet);
+
+	if (m_journal.IsOpen())
+	{
+		std::vector<CLayoutJournal::SPiece> pieces;
+		pieces.reserve(historySet->Dominoes.size());
+		for (CDominoWorldPartition::DominoId id : historySet->Dominoes)
+		{
+			const CDominoWorldPartition::SDominoRecord& record = Dominoes.GetRecord(id);
+			pieces.push_back({ record.restPosition, record.restRotation, record.kind });
+		}
+		m_journal.AppendStroke(historySet->m_isStroke, std::move(pieces));
+	}
+
+	History.push_back(std::move(historySet));
 	//History[m_historyStep]=historySet;
 	//m_historyStep++;
 
@@ -284,45 +545,103 @@ void CPlayerComponent::Undo()
 	if (n < 1)
 		return;
 	debug->Add2DText("Undoing " +ToString(n), 2, Col_White, 2);
-	for (IEntity* pDomino : History[n-1]->Dominoes) {
-		pDomino->Hide(true);
-	}
+	// One toggle for the whole stroke, however long it is
+	Dominoes.SetGroupHidden(History[n-1]->m_group, true);
+	m_isChainAnalysisDirty = true;
+	m_isPickerDirty = true;
+	m_replay.Clear();
 	m_undoSteps++;
-	
+	m_journal.AppendUndo();
 }
 
-void CPlayerComponent::Redo()
+void CPlayerComponent::AnalyzeChains()
 {
+	const CTimeValue start = gEnv->pTimer->GetAsyncTime();
+
+	m_chainAnalyzer.Clear();
+	for (const std::unique_ptr<SHistorySet>& pHistorySet : History)
+	{
+		if (pHistorySet->m_isStroke && !Dominoes.IsGroupHidden(pHistorySet->m_group))
+			m_chainAnalyzer.AnalyzeStroke(Dominoes, pHistorySet->Dominoes);
+	}
 
+	m_isChainAnalysisDirty = false;
+
+	const float elapsedMs = (gEnv->pTimer->GetAsyncTime() - start).GetMilliSeconds();
+	debug->Add2DText(ToString((int)m_chainAnalyzer.GetBreaks().size()) + " chain breaks (" + ToString(elapsedMs) + " ms)", 2, Col_Red, 3);
 }
 
-void CPlayerComponent::RestartHistory(int fromIndex)
+void CPlayerComponent::Redo()
 {
-	CryLog("Restarting from entry %n", fromIndex);
+	if (m_undoSteps < 1)
+		return;
 
-	int historySize = History.size();
+	m_undoSteps--;
+	const int n = History.size() - m_undoSteps;
+	debug->Add2DText("Redoing " + ToString(n), 2, Col_White, 2);
+	Dominoes.SetGroupHidden(History[n-1]->m_group, false);
+	m_isChainAnalysisDirty = true;
+	m_isPickerDirty = true;
+	m_replay.Clear();
+	m_journal.AppendRedo();
+}
 
-	//CryLog("History has %n entries", historySize);
+void CPlayerComponent::RecoverJournal()
+{
+	m_isJournalRecovered = true;
+	if (SDominoCVars::Get().d_dominoAutosave == 0)
+		return;
 
-	for (int i = fromIndex; fromIndex < historySize; i++)
-	{
-		//CryLog("Removing Entry: %n", i);
+	CLayoutJournal::SState state;
+	if (!m_journal.Open("%USER%/DominoLayout.journal", state))
+		return;
 
-		for (IEntity* pDomino : History[i]->Dominoes) {
-			RemoveDomino(pDomino);
+	// Rebuilt straight into the history, it is already in the journal
+	std::vector<CDominoWorldPartition::SPlacement> placements;
+	for (const CLayoutJournal::SStroke& stroke : state.strokes)
+	{
+		placements.clear();
+		for (const CLayoutJournal::SPiece& piece : stroke.pieces)
+		{
+			placements.push_back({ QuatT(piece.rotation, piece.position), piece.kind });
 		}
-		
-		//History.erase(i);
-		//History.erase(i);
-		//History.destroy(i);
+
+		std::unique_ptr<SHistorySet> pHistorySet = stl::make_unique<SHistorySet>();
+		pHistorySet->m_index = History.size() + 1;
+		pHistorySet->m_isStroke = stroke.isStroke;
+		pHistorySet->m_group = Dominoes.CreateGroup();
+		Dominoes.AddBatch(placements, pHistorySet->Dominoes, pHistorySet->m_group);
+		if (stroke.isHidden)
+			Dominoes.SetGroupHidden(pHistorySet->m_group, true);
+
+		m_placedDominoes += (int)placements.size();
+		History.push_back(std::move(pHistorySet));
+	}
+
+	m_undoSteps = state.undoSteps;
+	m_isChainAnalysisDirty = true;
+	m_isPickerDirty = true;
+	Dominoes.BakeActiveCells();
+}
+
+void CPlayerComponent::RestartHistory(int fromIndex)
+{
+	CryLog("Restarting from entry %d", fromIndex);
+
+	// One batch, so every touched cell is compacted once however many strokes go
+	std::vector<CDominoWorldPartition::DominoId> removed;
+	const int historySize = History.size();
+	for (int i = fromIndex; i < historySize; i++)
+	{
+		removed.insert(removed.end(), History[i]->Dominoes.begin(), History[i]->Dominoes.end());
 	}
-	History.shrink_to_fit();
+	Dominoes.Remove(removed);
 	History.resize(fromIndex);
-	
+
 	m_undoSteps = 0;
+	m_journal.AppendTruncate();
 	debug->Add2DText("Resulting in " + ToString(History.size()) + " entries", 2, Col_Blue, 5);
-	CryLog("Resulting in %n entries", History.size());
-	
+	CryLog("Resulting in %d entries", (int)History.size());
 }
 
 void CPlayerComponent::UpdatePlacementPosition(Vec3 o, float fTime)
@@ -334,45 +653,41 @@ void CPlayerComponent::UpdatePlacementPosition(Vec3 o, float fTime)
 	{
 		m_placementCurrentGoalPosition = m_placementDesiredGoalPosition;
 		
-		if (!m_ghostFirstDomino)
+		if (!m_strokePreview.HasCursor())
 			m_firstPlacedPosition = m_placementDesiredGoalPosition;
 		else 
-			m_firstPlacedPosition = m_ghostFirstDomino->GetWorldPos();
+			m_firstPlacedPosition = m_strokePreview.GetCursor().t;
 		
-		//if (!m_ghostFirstDomino)
+		//if (!m_strokePreview.HasCursor())
 		m_lastPlacedPosition = m_firstPlacedPosition;
 
 		CreateFirstGhost(m_firstPlacedPosition);
 	
 	}
 
-	m_placementCurrentGoalPosition = LERP(m_placementCurrentGoalPosition, m_placementDesiredGoalPosition, fTime);
+	m_placementCurrentGoalPosition = Smoothing::ExpSmooth(m_placementCurrentGoalPosition, m_placementDesiredGoalPosition, m_placementFollowRate, fTime);
 	float offset = .05;
 	
-	IRenderAuxGeom* g = gEnv->pAuxGeomRenderer->GetAux();
-	g->DrawSphere(m_placementDesiredGoalPosition + Vec3(0,0,offset), .1f, Col_Green, false);
-	g->DrawSphere(m_placementCurrentGoalPosition + Vec3(0, 0, offset *2), .1f, Col_Red, false);
-	g->DrawSphere(m_lastPlacedPosition + Vec3(0, 0, offset*3), .1f, Col_Cyan, false);
-	g->DrawSphere(m_firstPlacedPosition + Vec3(0, 0, offset*4), .1f, Col_White, false);
+	DOMINO_DEBUG_POINT(CDebugDraw::ELevel::Verbose, m_placementDesiredGoalPosition + Vec3(0,0,offset), Col_Green);
+	DOMINO_DEBUG_POINT(CDebugDraw::ELevel::Verbose, m_placementCurrentGoalPosition + Vec3(0, 0, offset *2), Col_Red);
+	DOMINO_DEBUG_POINT(CDebugDraw::ELevel::Verbose, m_lastPlacedPosition + Vec3(0, 0, offset*3), Col_Cyan);
+	DOMINO_DEBUG_POINT(CDebugDraw::ELevel::Verbose, m_firstPlacedPosition + Vec3(0, 0, offset*4), Col_White);
 
 	float dist = Distance::Point_Point(m_placementCurrentGoalPosition, m_lastPlacedPosition);
-
-	Vec3 dir = m_placementCurrentGoalPosition - m_lastPlacedPosition;
-	dir.normalize();
-
-	Vec3 n = dir * m_placementDistance;
-	Vec3 p = m_lastPlacedPosition + n;
 	
+	if (m_firstPlaced)
+	{
+		// Commit what the last job accepted, then hand the rest of the stroke to the next one
+		CommitPlacementCandidates();
+		SubmitPlacementSegment();
+		return;
+	}
+
 	if (dist > m_placementDistance)
 	{
-		if (m_firstPlaced) {
-			//PlaceDomino(m_placementCurrentGoalPosition);
-			PlaceDomino(p);
-			
-		}
 		if (!m_firstPlaced)
 		{
-			Quat firstDomRot = m_ghostFirstDomino->GetWorldRotation();
+			Quat firstDomRot = m_strokePreview.GetCursor().q;
 			DestroyFirstGhost();
 			PlaceDomino(m_firstPlacedPosition,firstDomRot);
 			Vec3 dir = m_placementCurrentGoalPosition - m_lastPlacedPosition;
@@ -389,22 +704,286 @@ void CPlayerComponent::UpdatePlacementPosition(Vec3 o, float fTime)
 
 //----------------------------------------------------------------------------------
 
-void CPlayerComponent::UpdateCursorPointer()
+void CPlayerComponent::SubmitPlacementSegment()
 {
+	if (m_placementPipeline.IsBusy() || m_isStrokeOverBudget)
+		return;
 
-		IRenderAuxGeom* g = gEnv->pAuxGeomRenderer->GetAux();
-		g->DrawSphere(GetPositionFromPointer(), .1f, Col_Yellow, true);
-	
+	const float dist = Distance::Point_Point2D(m_placementCurrentGoalPosition, m_lastPlacedPosition);
+	if (dist <= m_placementDistance)
+		return;
+
+	CPlacementPipeline::SSegment segment;
+	segment.from = m_lastPlacedPosition;
+	segment.to = m_placementCurrentGoalPosition;
+	segment.spacing = m_placementDistance;
+
+	// Snapshot of the pieces around the segment, the job must not read the partition
+	Dominoes.GatherRestPositions(segment.from, segment.to, m_placementDistance, segment.occupied);
+
+	// The stroke's own pieces aren't in the partition until release
+	const Vec2 minimum(min(segment.from.x, segment.to.x) - m_placementDistance, min(segment.from.y, segment.to.y) - m_placementDistance);
+	const Vec2 maximum(max(segment.from.x, segment.to.x) + m_placementDistance, max(segment.from.y, segment.to.y) + m_placementDistance);
+	for (const CDominoWorldPartition::SPlacement& pending : m_pendingStroke)
+	{
+		const Vec3& p = pending.transform.t;
+		if (p.x >= minimum.x && p.y >= minimum.y && p.x <= maximum.x && p.y <= maximum.y)
+			segment.occupied.push_back(p);
+	}
+
+	// The segment starts at the last committed piece, which is not an overlap
+	segment.occupied.erase(std::remove_if(segment.occupied.begin(), segment.occupied.end(), [&segment](const Vec3& p)
+		{
+			return Vec2(p - segment.from).GetLength2() < sqr(.001f);
+		}), segment.occupied.end());
+
+	m_placementPipeline.Submit(std::move(segment));
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::CommitPlacementCandidates()
+{
+	Vec3 end;
+	if (!m_placementPipeline.Collect(m_placementCandidates, end))
+		return;
+
+	// The budget is checked at every commit, one long stroke can't run past it
+	if (m_isStrokeOverBudget || !CheckMemoryBudget(m_pendingStroke.size() + m_placementCandidates.size()))
+	{
+		m_isStrokeOverBudget = true;
+		m_placementCandidates.clear();
+		return;
+	}
+
+	for (const CPlacementPipeline::SCandidate& candidate : m_placementCandidates)
+	{
+		m_placedDominoes++;
+		AddPendingPiece(candidate.position, candidate.rotation);
+	}
+
+	m_placementCandidates.clear();
+	m_lastPlacedPosition = end;
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::FinishStroke()
+{
+	// Never waits, a segment still in flight is collected on a later frame
+	CommitPlacementCandidates();
+	if (m_placementPipeline.IsBusy())
+		return;
+
+	if (m_firstPlaced && !m_isStrokeOverBudget && Distance::Point_Point2D(m_placementCurrentGoalPosition, m_lastPlacedPosition) > m_placementDistance)
+	{
+		SubmitPlacementSegment();
+		return;
+	}
+
+	CommitPendingStroke();
+
+	if (m_ActiveHistory != nullptr)
+		InsertHistorySet(std::move(m_ActiveHistory));
+
+	// The stroke is done, merge what was just placed into its chunk
+	if (!m_isSimulating)
+		Dominoes.BakeActiveCells();
+
+	m_placementActive = false;
+	m_isStrokeReleased = false;
+	m_firstPlaced = false;
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::CyclePlacementKind()
+{
+	// Switching mid-stroke would change the spacing under the pending segment
+	if (m_placementActive)
+		return;
+
+	m_placementKind = CDominoKindRegistry::Next(m_placementKind);
+
+	const SDominoKindDesc& kind = CDominoKindRegistry::Get(m_placementKind);
+	m_placementDistance = kind.spacing;
+	debug->Add2DText(string("Placing ") + kind.name + " dominoes", 2, Col_White, 2);
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::BeginSelection()
+{
+	m_isSelecting = true;
+	m_selectionStart = GetPositionFromPointer();
+	m_lasso.clear();
+	m_lasso.push_back(Vec2(m_selectionStart));
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::UpdateSelection()
+{
+	const Vec3 cursor = GetPositionFromPointer();
+	// Not a debug overlay, drawn through the frame batch at every level
+	CDebugDraw& draw = CDebugDraw::Get();
+
+	if (m_lassoModifier)
+	{
+		if ((Vec2(cursor) - m_lasso.back()).GetLength2() > sqr(m_placementDistance))
+			m_lasso.push_back(Vec2(cursor));
+
+		for (size_t i = 1; i < m_lasso.size(); i++)
+		{
+			draw.AddLine(Vec3(m_lasso[i - 1].x, m_lasso[i - 1].y, cursor.z), Vec3(m_lasso[i].x, m_lasso[i].y, cursor.z), Col_Yellow);
+		}
+	}
+	else
+	{
+		const AABB box(Vec3(min(m_selectionStart.x, cursor.x), min(m_selectionStart.y, cursor.y), min(m_selectionStart.z, cursor.z)),
+			Vec3(max(m_selectionStart.x, cursor.x), max(m_selectionStart.y, cursor.y), max(m_selectionStart.z, cursor.z) + .5f));
+		draw.AddAABB(box, Col_Yellow);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::EndSelection()
+{
+	m_isSelecting = false;
+	m_selection.clear();
+
+	const Vec3 cursor = GetPositionFromPointer();
+
+	if (m_lassoModifier)
+	{
+		m_lasso.push_back(Vec2(cursor));
+		Dominoes.QueryLasso(m_lasso, m_selection);
+	}
+	else
+	{
+		Dominoes.QueryBox(Vec2(min(m_selectionStart.x, cursor.x), min(m_selectionStart.y, cursor.y)),
+			Vec2(max(m_selectionStart.x, cursor.x), max(m_selectionStart.y, cursor.y)), m_selection);
+	}
+
+	// A click without a drag picks the hovered domino, a drag over nothing selects nothing
+	const bool isClick = (Vec2(cursor) - Vec2(m_selectionStart)).GetLength2() < sqr(m_clickTolerance);
+	if (m_selection.empty() && isClick && m_hoveredDomino != CDominoWorldPartition::InvalidId)
+		m_selection.push_back(m_hoveredDomino);
+
+	m_lasso.clear();
+	debug->Add2DText("Selected " + ToString((int)m_selection.size()), 2, Col_Yellow, 2);
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::CopySelection()
+{
+	if (m_selection.empty())
+		return;
+
+	Vec3 center = ZERO;
+	for (CDominoWorldPartition::DominoId id : m_selection)
+	{
+		center += Dominoes.GetRecord(id).restPosition;
+	}
+	center /= (float)m_selection.size();
+
+	m_clipboard.clear();
+	m_clipboard.reserve(m_selection.size());
+	m_clipboardRadius = 0;
+	m_clipboardRotation = 0;
+
+	for (CDominoWorldPartition::DominoId id : m_selection)
+	{
+		const CDominoWorldPartition::SDominoRecord& record = Dominoes.GetRecord(id);
+		const Vec3 offset = record.restPosition - center;
+		m_clipboard.push_back({ offset, record.restRotation, record.kind, record.pips });
+		m_clipboardRadius = max(m_clipboardRadius, Vec2(offset).GetLength());
+	}
+
+	debug->Add2DText("Copied " + ToString((int)m_clipboard.size()), 2, Col_Yellow, 2);
+}
+
+//----------------------------------------------------------------------------------
 
+void CPlayerComponent::PasteClipboard(int copies)
+{
+	if (m_clipboard.empty() || m_isSimulating || m_isReplaying || m_placementActive || copies < 1)
+		return;
+
+	const Vec3 origin = GetPositionFromPointer();
+	const Quat rotation = Quat::CreateRotationZ(m_clipboardRotation);
+
+	Vec3 right = m_lookOrientation.GetColumn0();
+	right.z = 0;
+	right.NormalizeSafe(Vec3(1, 0, 0));
+	const Vec3 step = right * (m_clipboardRadius * 2 + m_placementDistance);
+
+	std::vector<CDominoWorldPartition::SPlacement> placements;
+	placements.reserve(m_clipboard.size() * copies);
+
+	for (int copy = 0; copy < copies; copy++)
+	{
+		const Vec3 copyOrigin = origin + step * (float)copy;
+		for (const SClipboardPiece& piece : m_clipboard)
+		{
+			Vec3 position = copyOrigin + rotation * piece.offset;
+			position.z = gEnv->p3DEngine->GetTerrainElevation(position.x, position.y);
+			placements.push_back({ QuatT(rotation * piece.rotation, position), piece.kind, piece.pips });
+		}
+	}
+
+	// One spawn and one history record for the whole paste
+	if (!CheckMemoryBudget(placements.size()))
+		return;
+
+	std::unique_ptr<SHistorySet> pHistorySet = stl::make_unique<SHistorySet>();
+	pHistorySet->m_index = History.size() + 1;
+	pHistorySet->m_isStroke = false;
+	pHistorySet->m_group = Dominoes.CreateGroup();
+	Dominoes.AddBatch(placements, pHistorySet->Dominoes, pHistorySet->m_group);
+	InsertHistorySet(std::move(pHistorySet));
+
+	m_placedDominoes += (int)placements.size();
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::UpdateCursorPointer()
+{
+#if DOMINO_DEBUG_DRAW
+	// Only pay for the pointer raycast when the marker is actually drawn
+	if (CDebugDraw::IsEnabled(CDebugDraw::ELevel::Basic))
+		CDebugDraw::Get().AddPoint(GetPositionFromPointer(), Col_Yellow);
+#endif
 }
 
 //----------------------------------------------------------------------------------
 
 Vec3 CPlayerComponent::GetPositionFromPointer()
 {
-	
 	Vec3 curPos = m_placementCurrentGoalPosition;
 
+	Vec3 vPos0, vDir;
+	GetPointerRay(vPos0, vDir);
+
+	const unsigned int rayFlags = rwi_stop_at_pierceable | rwi_colltype_any;
+	ray_hit hit;
+
+	// Dominoes are picked by m_picker, the physics ray only needs the ground
+	int hits = gEnv->pPhysicalWorld->RayWorldIntersection(vPos0, vDir * gEnv->p3DEngine->GetMaxViewDistance(), ent_terrain | ent_static, rayFlags, &hit, 1);
+
+	if (hits > 0)
+		curPos = hit.pt;
+
+	return curPos;
+}
+
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::GetPointerRay(Vec3& origin, Vec3& direction) const
+{
 	float mouseX, mouseY;
 	gEnv->pHardwareMouse->GetHardwareMouseClientPosition(&mouseX, &mouseY);
 
@@ -417,25 +996,50 @@ Vec3 CPlayerComponent::GetPositionFromPointer()
 	Vec3 vPos1(0, 0, 0);
 	gEnv->pRenderer->UnProjectFromScreen(mouseX, mouseY, 1, &vPos1.x, &vPos1.y, &vPos1.z);
 
-	Vec3 vDir = vPos1 - vPos0;
-	vDir.Normalize();
+	origin = vPos0;
+	direction = (vPos1 - vPos0).GetNormalized();
+}
 
-	const unsigned int rayFlags = rwi_stop_at_pierceable | rwi_colltype_any;
-	ray_hit hit;
+//----------------------------------------------------------------------------------
 
-	int hits = gEnv->pPhysicalWorld->RayWorldIntersection(vPos0, vDir * gEnv->p3DEngine->GetMaxViewDistance(), ent_all, rayFlags, &hit, 1);
+void CPlayerComponent::UpdateHoveredDomino()
+{
+	if (m_isPickerDirty)
+	{
+		m_picker.Rebuild(Dominoes);
+		m_isPickerDirty = false;
+	}
 
+	Vec3 origin, direction;
+	GetPointerRay(origin, direction);
 
+#if DOMINO_DEBUG_DRAW
+	const CTimeValue start = gEnv->pTimer->GetAsyncTime();
+#endif
+	m_hoveredDomino = m_picker.Pick(origin, direction, gEnv->p3DEngine->GetMaxViewDistance());
 
-	if (hits > 0)
-		curPos = hit.pt;
+#if DOMINO_DEBUG_DRAW
+	// Side by side cost of the packed pick and the physics world ray it replaces
+	if (CDebugDraw::IsEnabled(CDebugDraw::ELevel::Verbose))
+	{
+		const float pickMs = (gEnv->pTimer->GetAsyncTime() - start).GetMilliSeconds();
 
-	return curPos;
+		const CTimeValue rayStart = gEnv->pTimer->GetAsyncTime();
+		ray_hit hit;
+		gEnv->pPhysicalWorld->RayWorldIntersection(origin, direction * gEnv->p3DEngine->GetMaxViewDistance(), ent_all, rwi_stop_at_pierceable | rwi_colltype_any, &hit, 1);
+		const float rayMs = (gEnv->pTimer->GetAsyncTime() - rayStart).GetMilliSeconds();
 
+		const string label = "Pick " + ToString((int)m_picker.GetCount()) + " boxes " + ToString(pickMs) + " ms, physics ray " + ToString(rayMs) + " ms";
+		DOMINO_DEBUG_LABEL(CDebugDraw::ELevel::Verbose, 10, 30, Col_Cyan, label.c_str());
+	}
+#endif
 
+	OBB box;
+	Vec3 center;
+	if (m_picker.GetBox(m_hoveredDomino, box, center))
+		CDebugDraw::Get().AddOBB(box, center, Col_Cyan);
 }
 
-
 //----------------------------------------------------------------------------------
 
 
@@ -455,10 +1059,10 @@ void CPlayerComponent::Revive(const Matrix34& transform)
 
 	m_mouseDeltaRotation = ZERO;
 	m_mouseDeltaSmoothingFilter.Reset();
+	m_mouseFrameTimeFilter.Reset();
 
 	m_lookOrientation = IDENTITY;
-	m_horizontalAngularVelocity = 0.0f;
-	m_averagedHorizontalAngularVelocity.Reset();
+	m_frameTimeStats.Reset();
 
 }
 void CPlayerComponent::ShowGhostCursor()
@@ -467,42 +1071,30 @@ void CPlayerComponent::ShowGhostCursor()
 void CPlayerComponent::CreateFirstGhost(Vec3 p)
 {
 
-	if (m_ghostFirstDomino != nullptr)
+	if (m_strokePreview.HasCursor())
 		return;
 
-	SEntitySpawnParams spawnParams;
-	spawnParams.pClass = gEnv->pEntitySystem->GetClassRegistry()->GetDefaultClass();
-	spawnParams.vPosition = p;
-	Vec3 dir = p - m_placementDesiredGoalPosition;
+	// Render-only, the piece is placed once the stroke is long enough
+	Vec3 dir = m_placementDesiredGoalPosition - p;
 	dir.z = 0;
-	spawnParams.qRotation = Quat::CreateRotationVDir(dir);
-
-	if (IEntity* pEntity = gEnv->pEntitySystem->SpawnEntity(spawnParams))
-	{
-		pEntity->CreateComponentClass<CDominoComponent>();
-		m_ghostFirstDomino = pEntity;
-	}
+	m_strokePreview.SetCursor(p, Quat::CreateRotationVDir(dir), m_placementKind);
 
 }
 void CPlayerComponent::UpdateFirstGhost(float fTime)
 {
-	if (!m_ghostFirstDomino)
+	if (!m_strokePreview.HasCursor())
 		return;
 
-	Vec3 v = m_ghostFirstDomino->GetWorldPos() - m_placementCurrentGoalPosition;
+	const Vec3 position = m_strokePreview.GetCursor().t;
+	// Faces down the stroke, like every piece placed after it
+	Vec3 v = m_placementCurrentGoalPosition - position;
 	//v.z = 0;
-	m_ghostFirstDomino->SetRotation(Quat::CreateRotationVDir(v));
+	m_strokePreview.SetCursor(position, Quat::CreateRotationVDir(v), m_placementKind);
 }
 
 void CPlayerComponent::DestroyFirstGhost()
 {
-	if (m_ghostFirstDomino == nullptr)
-		return;
-
-	
-	gEnv->pEntitySystem->RemoveEntity(m_ghostFirstDomino->GetId());
-	m_ghostFirstDomino = nullptr;
-	
+	m_strokePreview.HideCursor();
 }
 /*
 void CPlayerComponent::CreateGhostCursor()
@@ -536,57 +1128,53 @@ void CPlayerComponent::CreateGhostCursor()
 void CPlayerComponent::BindInputs()
 {
 	CryLog("Player: Attempting to bind inputs");
+
+	// Callbacks only record what happened, the events are applied in ProcessInputEvents during Update
 	m_pInputComponent->RegisterAction("player", "moveleft", [this](int activationMode, float value)
 		{
-			HandleInputFlagChange(EInputFlag::MoveLeft, (EActionActivationMode)activationMode);
+			QueueInputEvent(SPlayerInputEvent::EType::InputFlag, activationMode, value, (uint8)EInputFlag::MoveLeft);
 		});
 	m_pInputComponent->BindAction("player", "moveleft", eAID_KeyboardMouse, EKeyId::eKI_A);
 
 	m_pInputComponent->RegisterAction("player", "moveright", [this](int activationMode, float value)
 		{
-			HandleInputFlagChange(EInputFlag::MoveRight, (EActionActivationMode)activationMode);
+			QueueInputEvent(SPlayerInputEvent::EType::InputFlag, activationMode, value, (uint8)EInputFlag::MoveRight);
 		});
 	m_pInputComponent->BindAction("player", "moveright", eAID_KeyboardMouse, EKeyId::eKI_D);
 
 	m_pInputComponent->RegisterAction("player", "moveforward", [this](int activationMode, float value)
 		{
-			HandleInputFlagChange(EInputFlag::MoveForward, (EActionActivationMode)activationMode);
+			QueueInputEvent(SPlayerInputEvent::EType::InputFlag, activationMode, value, (uint8)EInputFlag::MoveForward);
 		});
 	m_pInputComponent->BindAction("player", "moveforward", eAID_KeyboardMouse, EKeyId::eKI_W);
 
 	m_pInputComponent->RegisterAction("player", "moveback", [this](int activationMode, float value)
 		{
-			HandleInputFlagChange(EInputFlag::MoveBack, (EActionActivationMode)activationMode);
+			QueueInputEvent(SPlayerInputEvent::EType::InputFlag, activationMode, value, (uint8)EInputFlag::MoveBack);
 		});
 	m_pInputComponent->BindAction("player", "moveback", eAID_KeyboardMouse, EKeyId::eKI_S);
 
 	m_pInputComponent->RegisterAction("player", "mouse_rotateyaw", [this](int activationMode, float value)
 		{
-			m_mouseDeltaRotation.x -= value;
+			QueueInputEvent(SPlayerInputEvent::EType::MouseYaw, activationMode, value);
 		});
 	m_pInputComponent->BindAction("player", "mouse_rotateyaw", eAID_KeyboardMouse, EKeyId::eKI_MouseX);
 
 	m_pInputComponent->RegisterAction("player", "mouse_rotatepitch", [this](int activationMode, float value)
 		{
-			m_mouseDeltaRotation.y -= value;
+			QueueInputEvent(SPlayerInputEvent::EType::MousePitch, activationMode, value);
 		});
 	m_pInputComponent->BindAction("player", "mouse_rotatepitch", eAID_KeyboardMouse, EKeyId::eKI_MouseY);
 
 	m_pInputComponent->RegisterAction("player", "mouse_scrolldown", [this](int activationMode, float value)
 		{
-
-			m_scrollY++;
-			m_scrollY = m_scrollY * m_scrollSpeedMultiplier;
-			
-
+			QueueInputEvent(SPlayerInputEvent::EType::Scroll, activationMode, 1.f);
 		});
 	m_pInputComponent->BindAction("player", "mouse_scrolldown", eAID_KeyboardMouse, EKeyId::eKI_MouseWheelDown);
 
 	m_pInputComponent->RegisterAction("player", "mouse_scrollup", [this](int activationMode, float value)
 		{
-			m_scrollY--;
-			m_scrollY = m_scrollY * m_scrollSpeedMultiplier;
-
+			QueueInputEvent(SPlayerInputEvent::EType::Scroll, activationMode, -1.f);
 		});
 	m_pInputComponent->BindAction("player", "mouse_scrollup", eAID_KeyboardMouse, EKeyId::eKI_MouseWheelUp);
 
@@ -600,13 +1188,7 @@ void CPlayerComponent::BindInputs()
 	m_pInputComponent->RegisterAction("player", "simulate", [this](int activationMode, float value)
 		{
 			if (activationMode == eAAM_OnPress)
-			{
-			if (!m_isSimulating)
-				BeginSimulation();
-			else
-				EndSimulation();
-			}
-
+				QueueInputEvent(SPlayerInputEvent::EType::Simulate, activationMode);
 		});
 	m_pInputComponent->BindAction("player", "simulate", eAID_KeyboardMouse, EKeyId::eKI_Space);
 
@@ -614,73 +1196,264 @@ void CPlayerComponent::BindInputs()
 	m_pInputComponent->RegisterAction("player", "undo", [this](int activationMode, float value)
 		{
 			if (activationMode == eAAM_OnPress)
-			{
-				Undo();
-			}
-
+				QueueInputEvent(SPlayerInputEvent::EType::Undo, activationMode);
 		});
 	m_pInputComponent->BindAction("player", "undo", eAID_KeyboardMouse, EKeyId::eKI_Z);
 
+	m_pInputComponent->RegisterAction("player", "redo", [this](int activationMode, float value)
+		{
+			if (activationMode == eAAM_OnPress)
+				QueueInputEvent(SPlayerInputEvent::EType::Redo, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "redo", eAID_KeyboardMouse, EKeyId::eKI_Y);
 
-	m_pInputComponent->RegisterAction("player", "pancam", [this](int activationMode, float value)
+
+	m_pInputComponent->RegisterAction("player", "selectmodifier", [this](int activationMode, float value)
 		{
+			QueueInputEvent(SPlayerInputEvent::EType::SelectModifier, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "selectmodifier", eAID_KeyboardMouse, EKeyId::eKI_LCtrl);
+
+	m_pInputComponent->RegisterAction("player", "lassomodifier", [this](int activationMode, float value)
+		{
+			QueueInputEvent(SPlayerInputEvent::EType::LassoModifier, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "lassomodifier", eAID_KeyboardMouse, EKeyId::eKI_LAlt);
 
+	m_pInputComponent->RegisterAction("player", "copy", [this](int activationMode, float value)
+		{
 			if (activationMode == eAAM_OnPress)
-			{
-				m_lookActive = true;
-			}
-			else if (activationMode == eAAM_OnRelease)
-			{
-				m_lookActive = false;
-			}
+				QueueInputEvent(SPlayerInputEvent::EType::Copy, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "copy", eAID_KeyboardMouse, EKeyId::eKI_C);
 
+	m_pInputComponent->RegisterAction("player", "paste", [this](int activationMode, float value)
+		{
+			if (activationMode == eAAM_OnPress)
+				QueueInputEvent(SPlayerInputEvent::EType::Paste, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "paste", eAID_KeyboardMouse, EKeyId::eKI_V);
 
+	m_pInputComponent->RegisterAction("player", "rotateclipboard", [this](int activationMode, float value)
+		{
+			if (activationMode == eAAM_OnPress)
+				QueueInputEvent(SPlayerInputEvent::EType::RotateClipboard, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "rotateclipboard", eAID_KeyboardMouse, EKeyId::eKI_R);
+
+	m_pInputComponent->RegisterAction("player", "stamp", [this](int activationMode, float value)
+		{
+			if (activationMode == eAAM_OnPress)
+				QueueInputEvent(SPlayerInputEvent::EType::Stamp, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "stamp", eAID_KeyboardMouse, EKeyId::eKI_T);
+
+
+	m_pInputComponent->RegisterAction("player", "cyclekind", [this](int activationMode, float value)
+		{
+			if (activationMode == eAAM_OnPress)
+				QueueInputEvent(SPlayerInputEvent::EType::CycleKind, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "cyclekind", eAID_KeyboardMouse, EKeyId::eKI_Tab);
+
+	m_pInputComponent->RegisterAction("player", "replay", [this](int activationMode, float value)
+		{
+			if (activationMode == eAAM_OnPress)
+				QueueInputEvent(SPlayerInputEvent::EType::Replay, activationMode);
+		});
+	m_pInputComponent->BindAction("player", "replay", eAID_KeyboardMouse, EKeyId::eKI_P);
+
+
+	m_pInputComponent->RegisterAction("player", "pancam", [this](int activationMode, float value)
+		{
+			QueueInputEvent(SPlayerInputEvent::EType::Look, activationMode);
 		});
 	m_pInputComponent->BindAction("player", "pancam", eAID_KeyboardMouse, EKeyId::eKI_Mouse2);
 
 
 	m_pInputComponent->RegisterAction("player", "select", [this](int activationMode, float value)
 		{
-			if (activationMode == eAAM_OnRelease)
-			{
+			QueueInputEvent(SPlayerInputEvent::EType::Select, activationMode);
+		});
 
-				if (m_ghostFirstDomino)
-					DestroyFirstGhost();
+	m_pInputComponent->BindAction("player", "select", eAID_KeyboardMouse, EKeyId::eKI_Mouse1);
 
-				if (m_undoSteps > 0) {
 
-					//RestartHistory(History.size() - m_undoSteps);
-				}
+	CryLog("Player: Successfully bound all controls");
 
-				if(m_ActiveHistory != nullptr)
-				InsertHistorySet(m_ActiveHistory);
+}
 
-				m_ActiveHistory = nullptr;
+//----------------------------------------------------------------------------------
 
-				m_placementActive = false;
-				m_firstPlaced = false;
-			}
+void CPlayerComponent::QueueInputEvent(SPlayerInputEvent::EType type, int activationMode, float value, uint8 flags)
+{
+	SPlayerInputEvent inputEvent;
+	inputEvent.type = type;
+	inputEvent.activationMode = (uint8)activationMode;
+	inputEvent.flags = flags;
+	inputEvent.value = value;
+
+	// A full queue drops the event rather than blocking or allocating
+	if (!m_inputEvents.Push(inputEvent))
+	{
+		// Reported once per frame by ProcessInputEvents
+		m_droppedInputEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+}
 
-			if (m_isSimulating)
-				return;
+//----------------------------------------------------------------------------------
 
-			if (activationMode == eAAM_OnPress)
-			{
-				m_placementActive = true;
-				m_ActiveHistory = new SHistorySet();
-				m_ActiveHistory->m_index = History.size() + 1;
-				//debug->Add2DText(ToString(m_ActiveHistroy->m_index), 2, Col_White, 2);
-			}
-		
-		});
+void CPlayerComponent::ProcessInputEvents()
+{
+	if (const uint32 dropped = m_droppedInputEvents.exchange(0, std::memory_order_relaxed))
+	{
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "Player: Input event queue full, dropped %u events", dropped);
+	}
 
-	m_pInputComponent->BindAction("player", "select", eAID_KeyboardMouse, EKeyId::eKI_Mouse1);
+	SPlayerInputEvent inputEvent;
+	while (m_inputEvents.Pop(inputEvent))
+	{
+		switch (inputEvent.type)
+		{
+		case SPlayerInputEvent::EType::InputFlag:
+			HandleInputFlagChange((EInputFlag)inputEvent.flags, (EActionActivationMode)inputEvent.activationMode);
+			break;
 
+		case SPlayerInputEvent::EType::MouseYaw:
+			m_mouseDeltaRotation.x -= inputEvent.value;
+			break;
 
-	CryLog("Player: Successfully bound all controls");
+		case SPlayerInputEvent::EType::MousePitch:
+			m_mouseDeltaRotation.y -= inputEvent.value;
+			break;
+
+		case SPlayerInputEvent::EType::Scroll:
+			// Every wheel notch moves by the same amount, no matter how many arrive in a frame
+			m_scrollY += inputEvent.value * m_scrollSpeedMultiplier;
+			break;
+
+		case SPlayerInputEvent::EType::Look:
+			if (inputEvent.activationMode == eAAM_OnPress)
+				m_lookActive = true;
+			else if (inputEvent.activationMode == eAAM_OnRelease)
+				m_lookActive = false;
+			break;
 
+		case SPlayerInputEvent::EType::Select:
+			HandleSelectInput(inputEvent.activationMode);
+			break;
+
+		case SPlayerInputEvent::EType::Simulate:
+			if (!m_isSimulating)
+				BeginSimulation();
+			else
+				EndSimulation();
+			break;
+
+		case SPlayerInputEvent::EType::Undo:
+			Undo();
+			break;
+
+		case SPlayerInputEvent::EType::Redo:
+			Redo();
+			break;
+
+		case SPlayerInputEvent::EType::SelectModifier:
+			m_selectModifier = inputEvent.activationMode != eAAM_OnRelease;
+			break;
+
+		case SPlayerInputEvent::EType::LassoModifier:
+			m_lassoModifier = inputEvent.activationMode != eAAM_OnRelease;
+			break;
+
+		case SPlayerInputEvent::EType::Copy:
+			CopySelection();
+			break;
+
+		case SPlayerInputEvent::EType::Paste:
+			PasteClipboard(1);
+			break;
+
+		case SPlayerInputEvent::EType::RotateClipboard:
+			m_clipboardRotation += m_clipboardRotationStep;
+			break;
+
+		case SPlayerInputEvent::EType::Stamp:
+			PasteClipboard(m_stampCount);
+			break;
+
+		case SPlayerInputEvent::EType::CycleKind:
+			CyclePlacementKind();
+			break;
+
+		case SPlayerInputEvent::EType::Replay:
+			if (!m_isReplaying)
+				BeginReplay();
+			else
+				EndReplay();
+			break;
+		}
+	}
 }
 
+//----------------------------------------------------------------------------------
+
+void CPlayerComponent::HandleSelectInput(int activationMode)
+{
+	if (activationMode == eAAM_OnPress && m_selectModifier && !m_isSimulating)
+	{
+		BeginSelection();
+		return;
+	}
+
+	if (m_isSelecting)
+	{
+		if (activationMode == eAAM_OnRelease)
+			EndSelection();
+		return;
+	}
+
+	if (activationMode == eAAM_OnRelease)
+	{
+
+		if (m_strokePreview.HasCursor())
+			DestroyFirstGhost();
+
+		// The rest of the stroke up to the release point is laid out over the next frames, see FinishStroke
+		if (m_placementActive && !m_isStrokeReleased)
+		{
+			m_placementCurrentGoalPosition = m_placementDesiredGoalPosition;
+			m_isStrokeReleased = true;
+			FinishStroke();
+		}
+	}
+
+	if (m_isSimulating || m_isReplaying)
+		return;
+
+	if (activationMode == eAAM_OnPress)
+	{
+		// A stroke released a frame ago may still have a segment in flight, it is finished here rather than dropped
+		while (m_isStrokeReleased)
+		{
+			m_placementPipeline.Wait();
+			FinishStroke();
+		}
+
+		if (!CheckMemoryBudget(0))
+			return;
+
+		m_isStrokeOverBudget = false;
+		m_placementActive = true;
+		m_ActiveHistory = stl::make_unique<SHistorySet>();
+		m_ActiveHistory->m_index = History.size() + 1;
+		m_ActiveHistory->m_group = Dominoes.CreateGroup();
+		//debug->Add2DText(ToString(m_ActiveHistroy->m_index), 2, Col_White, 2);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
 void CPlayerComponent::UpdateCameraTargetGoal(float fTime)
 {
 
@@ -707,8 +1480,8 @@ void CPlayerComponent::UpdateCameraTargetGoal(float fTime)
 			m_cameraDesiredGoalPosition += ((GetTacticalCameraMovementInputDirection() * m_goalSpeed * m_panSensitivity) * fTime);
 	}
 	
-	Vec3 pos = Lerp(m_cameraCurrentGoalPosition, m_cameraDesiredGoalPosition, fTime  * m_goalTension);
-	m_cameraCurrentGoalPosition = pos;
+	// Critically damped, at twice m_goalTension so it settles in about the time the old m_goalTension rate did
+	m_cameraCurrentGoalPosition = m_cameraGoalSpring.Update(m_cameraDesiredGoalPosition, m_goalTension * 2.f, fTime);
 	m_desiredCameraTranform.SetRotation33(Matrix33(IDENTITY));
 	m_desiredCameraTranform.SetTranslation(m_cameraCurrentGoalPosition);
 
@@ -727,7 +1500,24 @@ void CPlayerComponent::UpdateTacticalViewDirection(float fTime) {
 
 	Ang3 ypr = CCamera::CreateAnglesYPR(Matrix33(m_lookOrientation));
 
-	if (!m_mouseDeltaRotation.IsZero())
+	// Fed every frame while looking so the smoothed delta settles back to zero, emptied on release
+	// so the camera stops as soon as the button goes up
+	if (m_lookActive)
+	{
+		m_mouseDeltaSmoothingFilter.Push(m_mouseDeltaRotation);
+		m_mouseFrameTimeFilter.Push(fTime);
+	}
+	else
+	{
+		m_mouseDeltaSmoothingFilter.Reset();
+		m_mouseFrameTimeFilter.Reset();
+	}
+
+	// Mouse speed over the window applied for this frame's time, so short and long frames weigh by their length
+	const float windowFrameTime = m_mouseFrameTimeFilter.Mean();
+	const Vec2 smoothedDelta = m_lookActive && windowFrameTime > 0.f ? m_mouseDeltaSmoothingFilter.Mean() * (fTime / windowFrameTime) : Vec2(ZERO);
+
+	if (!m_mouseDeltaRotation.IsZero() || !smoothedDelta.IsZero())
 	{
 
 		float rotationLimitsMinPitch = -1.2f;
@@ -736,8 +1526,8 @@ void CPlayerComponent::UpdateTacticalViewDirection(float fTime) {
 		float rotationLimitsMaxPitch = -.4f;
 
 		if (m_lookActive) {
-			ypr.x += m_mouseDeltaRotation.x * m_rotationSensitivity;
-			ypr.y = CLAMP(ypr.y + m_mouseDeltaRotation.y * m_rotationSensitivity, rotationLimitsMinPitch, rotationLimitsMaxPitch);
+			ypr.x += smoothedDelta.x * m_rotationSensitivity;
+			ypr.y = CLAMP(ypr.y + smoothedDelta.y * m_rotationSensitivity, rotationLimitsMinPitch, rotationLimitsMaxPitch);
 		}
 		else
 			ypr.y = CLAMP(ypr.y, rotationLimitsMinPitch, rotationLimitsMaxPitch);
@@ -773,8 +1563,7 @@ void CPlayerComponent::UpdateZoom(float frameTime)
 	
 
 
-		float f = Lerp(m_currViewDistance, m_desiredViewDistance, frameTime);// *m_zoomTension);
-	m_currViewDistance = f;
+	m_currViewDistance = m_zoomSpring.Update(m_desiredViewDistance, m_zoomStiffness, frameTime);
 	m_scrollY = 0;
 
 }
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <array>
-#include <numeric>
+#include <atomic>
+#include <memory>
 
 #include <CryEntitySystem/IEntityComponent.h>
 #include <CryMath/Cry_Camera.h>
@@ -23,6 +24,20 @@
 
 #include "PersistantDebug.h"
 
+#include "InputEventQueue.h"
+#include "Smoothing.h"
+#include "RingStatistics.h"
+#include "DominoWorldPartition.h"
+#include "PlacementPipeline.h"
+#include "ChainAnalyzer.h"
+#include "SimulationReplay.h"
+#include "DominoPicker.h"
+#include "DominoAudio.h"
+#include "DominoIslands.h"
+#include "ChainTelemetry.h"
+#include "LayoutJournal.h"
+#include "StrokePreview.h"
+
 ////////////////////////////////////////////////////////
 // Represents a player participating in gameplay
 ////////////////////////////////////////////////////////
@@ -46,59 +61,6 @@ class CPlayerComponent final : public IEntityComponent
 
 	static constexpr EEntityAspects InputAspect = eEA_GameClientD;
 
-	template<typename T, size_t SAMPLES_COUNT>
-	class MovingAverage
-	{
-		static_assert(SAMPLES_COUNT > 0, "SAMPLES_COUNT shall be larger than zero!");
-
-	public:
-
-		MovingAverage()
-			: m_values()
-			, m_cursor(SAMPLES_COUNT)
-			, m_accumulator()
-		{
-		}
-
-		MovingAverage& Push(const T& value)
-		{
-			if (m_cursor == SAMPLES_COUNT)
-			{
-				m_values.fill(value);
-				m_cursor = 0;
-				m_accumulator = std::accumulate(m_values.begin(), m_values.end(), T(0));
-			}
-			else
-			{
-				m_accumulator -= m_values[m_cursor];
-				m_values[m_cursor] = value;
-				m_accumulator += m_values[m_cursor];
-				m_cursor = (m_cursor + 1) % SAMPLES_COUNT;
-			}
-
-			return *this;
-		}
-
-		T Get() const
-		{
-			return m_accumulator / T(SAMPLES_COUNT);
-		}
-
-		void Reset()
-		{
-			m_cursor = SAMPLES_COUNT;
-		}
-
-	private:
-
-		std::array<T, SAMPLES_COUNT> m_values;
-		size_t m_cursor;
-
-		T m_accumulator;
-	};
-
-
-
 public:
 	CPlayerComponent() = default;
 	virtual ~CPlayerComponent() = default;
@@ -108,6 +70,7 @@ public:
 
 	virtual Cry::Entity::EventFlags GetEventMask() const override;
 	virtual void ProcessEvent(const SEntityEvent& event) override;
+	virtual void GetMemoryUsage(ICrySizer* pSizer) const override;
 	// ~IEntityComponent
 
 	// Reflect type to set a unique identifier for this component
@@ -134,6 +97,9 @@ protected:
 	void HandleInputFlagChange(CEnumFlags<EInputFlag> flags, CEnumFlags<EActionActivationMode> activationMode, EInputFlagType type = EInputFlagType::Hold);
 
 	void BindInputs();
+	void QueueInputEvent(SPlayerInputEvent::EType type, int activationMode, float value = 0.f, uint8 flags = 0);
+	void ProcessInputEvents();
+	void HandleSelectInput(int activationMode);
 
 	void InitializeLocalPlayer();
 
@@ -160,19 +126,25 @@ protected:
 protected:
 	IPersistantDebug* debug;
 
-	float waterLevel = 16;
+	float waterLevel = DominoWorld::WaterLevel;
 	Cry::DefaultComponents::CCameraComponent* m_pCameraComponent = nullptr;
 	Cry::DefaultComponents::CInputComponent* m_pInputComponent = nullptr;
 
 protected:
 	CEnumFlags<EInputFlag> m_inputFlags;
+	CInputEventQueue m_inputEvents;
+	//Events the full queue turned away since the last ProcessInputEvents
+	std::atomic<uint32> m_droppedInputEvents { 0 };
 	Vec2 m_mouseDeltaRotation;
 
-	MovingAverage<Vec2, 10> m_mouseDeltaSmoothingFilter;
+	//Mouse deltas and the frame times they were gathered over, their ratio is the smoothed mouse speed
+	CRingStatistics<Vec2, 4> m_mouseDeltaSmoothingFilter;
+	CRingStatistics<float, 4> m_mouseFrameTimeFilter;
 
 	Quat m_lookOrientation = IDENTITY; //!< Should translate to head orientation in the future
-	float m_horizontalAngularVelocity = 0;
-	MovingAverage<float, 10> m_averagedHorizontalAngularVelocity;
+
+	//Frame time telemetry shown in the debug overlay
+	CRingStatistics<float, 128> m_frameTimeStats;
 
 	const char* m_playerName = "Moose";
 
@@ -203,13 +175,16 @@ protected:
 
 	bool m_lookActive;
 	const float m_rotationSensitivity = 0.002f;
-	float m_scrollY;
+	float m_scrollY = 0;
 	float m_scrollSpeedMultiplier = 0.2f;
 
 	float m_desiredViewDistance = 30;
 	float m_currViewDistance = 30;
 
-	float m_zoomTension = 0.3f;//1.7f;
+	//Angular frequency of the zoom spring, in radians per second
+	//Twice the 1/s rate the zoom used to follow at, which settles in about the same time
+	float m_zoomStiffness = 2.f;
+	Smoothing::CCriticallyDampedSpring<float> m_zoomSpring;
 
 	//How close can a camera get
 	float m_minViewDistance = 1;
@@ -223,6 +198,7 @@ protected:
 
 	float m_goalTension = 2.f;
 	float m_goalSpeed = 2.f;
+	Smoothing::CCriticallyDampedSpring<Vec3> m_cameraGoalSpring;
 	
 	Matrix34 m_desiredCameraTranform;
 
@@ -233,27 +209,56 @@ protected:
 
 	Vec3 m_placementDesiredGoalPosition = Vec3(0);
 	Vec3 m_placementCurrentGoalPosition = Vec3(0);
+	//Rate at which the placement goal follows the cursor, in 1/seconds
+	float m_placementFollowRate = 1.f;
 
 	void UpdatePlacementPosition(Vec3 o, float fTime);
 
 	//if a fleet is selected, then you can select any vessel in the fleet and drive it
 	void UpdateCursorPointer();
 	Vec3 GetPositionFromPointer();
+	void GetPointerRay(Vec3& origin, Vec3& direction) const;
+
+	//Hover and click picking against the resting dominoes, rebuilt when the layout changes
+	CDominoPicker m_picker;
+	bool m_isPickerDirty = true;
+	CDominoWorldPartition::DominoId m_hoveredDomino = CDominoWorldPartition::InvalidId;
+	void UpdateHoveredDomino();
 
 	bool m_placementActive = false;
-	DynArray<IEntity*> Dominoes;
-	DynArray<IEntity*> JustPlacedDominoes;
+	//Every placed domino, only the ones near the camera or a running chain have entities
+	CDominoWorldPartition Dominoes;
 	IEntity* m_firstPlacedDomino = nullptr;
-	IEntity* m_ghostFirstDomino = nullptr;
 	IEntity* m_ghostCursorDomino = nullptr;
 	Vec3 m_lastPlacedPosition = Vec3(0);
 	Vec3 m_firstPlacedPosition = Vec3(0);
 
 	void PlaceDomino(Vec3 pos, Quat rot = IDENTITY);
 
+	//The stroke being drawn is only ghosts, its pieces become dominoes in one batch on release
+	CStrokePreview m_strokePreview;
+	std::vector<CDominoWorldPartition::SPlacement> m_pendingStroke;
+	void AddPendingPiece(const Vec3& position, const Quat& rotation);
+	void CommitPendingStroke();
+
+	//Stroke segments are laid out by a job, the results are committed here on the main thread
+	CPlacementPipeline m_placementPipeline;
+	std::vector<CPlacementPipeline::SCandidate> m_placementCandidates;
+	void SubmitPlacementSegment();
+	void CommitPlacementCandidates();
+	//Set once a refused budget check ends the stroke early, cleared on the next press
+	bool m_isStrokeOverBudget = false;
+	//Between release and the last segment's commit, the stroke no longer follows the cursor
+	bool m_isStrokeReleased = false;
+	//Collects and submits the released stroke's remaining segments, commits the stroke once none are left
+	void FinishStroke();
+
 	bool m_firstPlaced = false;
 
-	float m_placementDistance = .3f;
+	//Kind of the pieces being placed, the spacing follows it
+	EDominoKind m_placementKind = EDominoKind::Standard;
+	float m_placementDistance = SDominoKindTraits<EDominoKind::Standard>::Spacing;
+	void CyclePlacementKind();
 	int m_placedDominoes = 0;
 
 	void BeginSimulation();
@@ -263,19 +268,100 @@ protected:
 	
 	bool m_isSimulating = false;
 
+	//Clicks of the running chain, heard from the camera
+	CDominoAudio m_audio;
+	//Independent chains of the simulated layout, quiet ones are put to sleep
+	CDominoIslands m_islands;
+	//Wake, topple and settle times of the last run, see d_dominoTelemetry
+	CChainTelemetry m_telemetry;
+
+	//Every simulation run is recorded, the last one can be replayed without physics
+	CSimulationReplay m_replay;
+	bool m_isReplaying = false;
+	void BeginReplay();
+	void EndReplay();
+
 	struct SHistorySet 
 	{
 		int m_index = 0;
-		std::vector<IEntity*> Dominoes;
+		//Strokes keep their placement order, which is the order the chain falls in
+		bool m_isStroke = true;
+		//Undo hides the whole group at once
+		CDominoWorldPartition::GroupId m_group = CDominoWorldPartition::InvalidGroup;
+		std::vector<CDominoWorldPartition::DominoId> Dominoes;
 	};
-	SHistorySet* m_ActiveHistory = nullptr;
-	DynArray<SHistorySet*> History;
+	std::unique_ptr<SHistorySet> m_ActiveHistory;
+	std::vector<std::unique_ptr<SHistorySet>> History;
 
-	void RemoveDomino(IEntity* Domino);
+	void RemoveDomino(CDominoWorldPartition::DominoId Domino);
 
-	void InsertHistorySet(SHistorySet* historySet);
+	void InsertHistorySet(std::unique_ptr<SHistorySet> historySet);
 	int m_historyStep= 0;
 
+	//Every history change is journaled in the background, the journal is replayed once the assets are in
+	CLayoutJournal m_journal;
+	bool m_isJournalRecovered = false;
+	void RecoverJournal();
+
+	////////////////////// SELECTION /////////////////////////////
+
+	//Select with the modifier held drags a box, with the lasso modifier as well it draws a lasso
+	bool m_selectModifier = false;
+	bool m_lassoModifier = false;
+	bool m_isSelecting = false;
+	Vec3 m_selectionStart = ZERO;
+	//A selection dragged less than this far on the ground counts as a click
+	float m_clickTolerance = .1f;
+	std::vector<Vec2> m_lasso;
+	std::vector<CDominoWorldPartition::DominoId> m_selection;
+
+	struct SClipboardPiece
+	{
+		//Relative to the centre of the copied selection
+		Vec3 offset;
+		Quat rotation;
+		EDominoKind kind;
+		//Pasted pieces look like the ones they were copied from
+		std::array<uint8, 4> pips;
+	};
+	std::vector<SClipboardPiece> m_clipboard;
+	float m_clipboardRadius = 0;
+	float m_clipboardRotation = 0;
+	float m_clipboardRotationStep = gf_PI / 12;
+	int m_stampCount = 5;
+
+	void BeginSelection();
+	void UpdateSelection();
+	void EndSelection();
+	void CopySelection();
+	//Pastes the clipboard at the cursor, repeated along the camera's right axis for array stamps
+	void PasteClipboard(int copies);
+
+	//Gaps the chain can't carry over, re-checked whenever the layout changes
+	CChainAnalyzer m_chainAnalyzer;
+	bool m_isChainAnalysisDirty = false;
+	void AnalyzeChains();
+
+	////////////////////// MEMORY /////////////////////////////
+
+	//Refreshed once a second while the overlay or a budget needs it, measuring walks every materialized domino
+	CDominoWorldPartition::SMemoryStats m_memoryStats;
+	size_t m_historyBytes = 0;
+	float m_memoryStatsAge = 0;
+	//Domino count the sample was taken at, the budget check extrapolates from it
+	size_t m_memoryStatsCount = 0;
+	bool m_isMemoryMeasured = false;
+	void UpdateMemoryStats(float frameTime);
+	//Takes the sample now, resets its age
+	void MeasureMemory();
+	//Dominoes, LOD, contacts, islands, memory, replay and frame time lines, d_dominoDebugDraw 1 and up
+	void DrawStats();
+	size_t GetMemoryTotal() const { return m_memoryStats.GetTotal() + m_historyBytes; }
+	//Checks the layout plus additionalDominoes against d_dominoMemoryBudget, false if the placement is refused
+	bool CheckMemoryBudget(size_t additionalDominoes);
+	//Warn-only budgets warn once until the layout is back under them
+	bool m_isBudgetWarned = false;
+
 	int m_undoSteps = 0;
 	void Undo();
 	void Redo();
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+
+////////////////////////////////////////////////////////
+// Fixed window statistics over the last SAMPLES_COUNT pushed values
+// Mean is O(1), the rest is computed on demand over the window, percentiles once per push
+////////////////////////////////////////////////////////
+
+template<typename T, size_t SAMPLES_COUNT>
+class CRingStatistics
+{
+	static_assert(SAMPLES_COUNT > 0 && (SAMPLES_COUNT & (SAMPLES_COUNT - 1)) == 0, "SAMPLES_COUNT shall be a power of two!");
+
+	static constexpr size_t Mask = SAMPLES_COUNT - 1;
+
+public:
+
+	CRingStatistics()
+		: m_cursor(0)
+		, m_isSeeded(false)
+		, m_isSortedValid(false)
+		, m_accumulator(ZERO)
+	{
+	}
+
+	CRingStatistics& Push(const T& value)
+	{
+		m_isSortedValid = false;
+
+		if (!m_isSeeded)
+		{
+			// Seed the whole window so the mean starts at the first sample
+			m_values.fill(value);
+			m_isSeeded = true;
+			m_cursor = 0;
+			Recalculate();
+			return *this;
+		}
+
+		m_accumulator -= m_values[m_cursor];
+		m_values[m_cursor] = value;
+		m_accumulator += value;
+		m_cursor = (m_cursor + 1) & Mask;
+
+		// Rebuild the running sum once per lap so float error can't build up
+		if (m_cursor == 0)
+		{
+			Recalculate();
+		}
+
+		return *this;
+	}
+
+	void Reset()
+	{
+		m_isSeeded = false;
+		m_isSortedValid = false;
+		m_cursor = 0;
+		m_accumulator = ZERO;
+	}
+
+	bool IsEmpty() const { return !m_isSeeded; }
+
+	T Get() const { return Mean(); }
+
+	T Mean() const
+	{
+		if (!m_isSeeded)
+			return T(ZERO);
+
+		return m_accumulator * (1.f / float(SAMPLES_COUNT));
+	}
+
+	// The following are only available for scalar sample types
+
+	T Variance() const
+	{
+		if (!m_isSeeded)
+			return T(0);
+
+		const T mean = Mean();
+		std::array<T, Lanes> lanes;
+		lanes.fill(T(0));
+
+		for (size_t i = 0; i < SAMPLES_COUNT; i += Lanes)
+		{
+			for (size_t lane = 0; lane < Lanes; ++lane)
+			{
+				const T d = m_values[i + lane] - mean;
+				lanes[lane] += d * d;
+			}
+		}
+
+		return SumLanes(lanes) / T(SAMPLES_COUNT);
+	}
+
+	T Min() const
+	{
+		return !m_isSeeded ? T(0) : *std::min_element(m_values.begin(), m_values.end());
+	}
+
+	T Max() const
+	{
+		return !m_isSeeded ? T(0) : *std::max_element(m_values.begin(), m_values.end());
+	}
+
+	// Nearest-rank percentile over the window, fraction in [0, 1]
+	// The window is sorted on the first call after a push, further calls are a lookup
+	T Percentile(float fraction) const
+	{
+		if (!m_isSeeded)
+			return T(0);
+
+		if (!m_isSortedValid)
+		{
+			m_sorted = m_values;
+			std::sort(m_sorted.begin(), m_sorted.end());
+			m_isSortedValid = true;
+		}
+
+		const size_t rank = std::min(size_t(fraction * float(SAMPLES_COUNT)), SAMPLES_COUNT - 1);
+		return m_sorted[rank];
+	}
+
+	static constexpr size_t Size() { return SAMPLES_COUNT; }
+
+private:
+
+	// Independent partial sums, lets the compiler keep them in one SIMD register for large windows
+	static constexpr size_t Lanes = SAMPLES_COUNT < 4 ? SAMPLES_COUNT : 4;
+
+	template<typename U>
+	static T SumLanes(const std::array<U, Lanes>& lanes)
+	{
+		T sum = lanes[0];
+		for (size_t lane = 1; lane < Lanes; ++lane)
+			sum += lanes[lane];
+		return sum;
+	}
+
+	void Recalculate()
+	{
+		std::array<T, Lanes> lanes;
+		lanes.fill(T(ZERO));
+
+		for (size_t i = 0; i < SAMPLES_COUNT; i += Lanes)
+		{
+			for (size_t lane = 0; lane < Lanes; ++lane)
+			{
+				lanes[lane] += m_values[i + lane];
+			}
+		}
+
+		m_accumulator = SumLanes(lanes);
+	}
+
+	std::array<T, SAMPLES_COUNT> m_values;
+	size_t m_cursor;
+	bool m_isSeeded;
+
+	// Sorted copy of m_values for Percentile, valid until the next Push
+	mutable std::array<T, SAMPLES_COUNT> m_sorted;
+	mutable bool m_isSortedValid;
+
+	T m_accumulator;
+};
@@ -0,0 +1,363 @@
+#include "StdAfx.h"
+#include "SimulationReplay.h"
+
+#include <algorithm>
+
+namespace
+{
+	// 1mm steps, +-32m around the rest position
+	constexpr float PositionScale = 1024.f;
+	// The smallest three components of a unit quaternion lie within +-1/sqrt(2)
+	constexpr float RotationScale = 32767.f * 1.41421356f;
+
+	int16 QuantizeComponent(float value, float scale)
+	{
+		return (int16)clamp_tpl((int)floor_tpl(value * scale + .5f), -32767, 32767);
+	}
+
+	void WriteVarint(std::vector<uint8>& data, uint32 value)
+	{
+		while (value >= 0x80)
+		{
+			data.push_back((uint8)(value | 0x80));
+			value >>= 7;
+		}
+		data.push_back((uint8)value);
+	}
+
+	uint32 ReadVarint(const std::vector<uint8>& data, size_t& offset)
+	{
+		uint32 value = 0;
+		for (uint32 shift = 0; offset < data.size(); shift += 7)
+		{
+			const uint8 byte = data[offset++];
+			value |= (uint32)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				break;
+		}
+		return value;
+	}
+
+	// Zigzag keeps small negative deltas in a single byte
+	void WriteDelta(std::vector<uint8>& data, int32 delta)
+	{
+		WriteVarint(data, ((uint32)delta << 1) ^ (uint32)(delta >> 31));
+	}
+
+	int32 ReadDelta(const std::vector<uint8>& data, size_t& offset)
+	{
+		const uint32 value = ReadVarint(data, offset);
+		return (int32)(value >> 1) ^ -(int32)(value & 1);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool CSimulationReplay::SQuantizedPose::operator==(const SQuantizedPose& other) const
+{
+	return largest == other.largest
+		&& position[0] == other.position[0] && position[1] == other.position[1] && position[2] == other.position[2]
+		&& rotation[0] == other.rotation[0] && rotation[1] == other.rotation[1] && rotation[2] == other.rotation[2];
+}
+
+//----------------------------------------------------------------------------------
+
+CSimulationReplay::SQuantizedPose CSimulationReplay::Quantize(const CDominoWorldPartition::SDominoRecord& record, const Vec3& position, const Quat& rotation)
+{
+	SQuantizedPose pose;
+
+	const Vec3 offset = position - record.restPosition;
+	pose.position[0] = QuantizeComponent(offset.x, PositionScale);
+	pose.position[1] = QuantizeComponent(offset.y, PositionScale);
+	pose.position[2] = QuantizeComponent(offset.z, PositionScale);
+
+	const Quat relative = (record.restRotation.GetInverted() * rotation).GetNormalized();
+	float components[4] = { relative.v.x, relative.v.y, relative.v.z, relative.w };
+
+	pose.largest = 0;
+	for (uint8 i = 1; i < 4; i++)
+	{
+		if (fabs_tpl(components[i]) > fabs_tpl(components[pose.largest]))
+			pose.largest = i;
+	}
+
+	// q and -q are the same rotation, keep the implied component positive
+	const float sign = components[pose.largest] < 0.f ? -1.f : 1.f;
+	for (uint8 i = 0, j = 0; i < 4; i++)
+	{
+		if (i != pose.largest)
+			pose.rotation[j++] = QuantizeComponent(components[i] * sign, RotationScale);
+	}
+
+	return pose;
+}
+
+//----------------------------------------------------------------------------------
+
+QuatT CSimulationReplay::Dequantize(const CDominoWorldPartition::SDominoRecord& record, const SQuantizedPose& pose)
+{
+	float components[4];
+	float sum = 0.f;
+	for (uint8 i = 0, j = 0; i < 4; i++)
+	{
+		if (i == pose.largest)
+			continue;
+
+		components[i] = (float)pose.rotation[j++] / RotationScale;
+		sum += sqr(components[i]);
+	}
+	components[pose.largest] = sqrt_tpl(max(1.f - sum, 0.f));
+
+	const Quat relative = Quat(components[3], components[0], components[1], components[2]).GetNormalized();
+	const Vec3 offset((float)pose.position[0], (float)pose.position[1], (float)pose.position[2]);
+
+	return QuatT(record.restRotation * relative, record.restPosition + offset / PositionScale);
+}
+
+//----------------------------------------------------------------------------------
+
+void CSimulationReplay::BeginRecording(const CDominoWorldPartition& partition)
+{
+	Clear();
+
+	m_poses.resize(partition.GetIdCount());
+	m_isRecording = true;
+	// Take the first sample straight away, it holds the initial push
+	m_sampleTime = 1.f / m_sampleRate;
+}
+
+//----------------------------------------------------------------------------------
+
+bool CSimulationReplay::Record(const CDominoWorldPartition& partition, float frameTime)
+{
+	if (!m_isRecording)
+		return false;
+
+	m_sampleTime += frameTime;
+	if (m_sampleTime < 1.f / m_sampleRate)
+		return true;
+
+	m_sampleTime = fmodf(m_sampleTime, 1.f / m_sampleRate);
+
+	if (GetByteCount() >= m_maxBytes)
+	{
+		CryLogAlways("Replay: Recording stopped at %.1f seconds, the %d KB budget is used up", GetDuration(), (int)(m_maxBytes >> 10));
+		m_isRecording = false;
+		return false;
+	}
+
+	const bool isNewChunk = m_chunks.empty() || (m_framesPerChunk > 0 && m_frameCount - m_chunks.back().firstFrame >= m_framesPerChunk);
+	if (isNewChunk)
+	{
+		m_chunks.emplace_back();
+		SChunk& chunk = m_chunks.back();
+		chunk.firstFrame = m_frameCount;
+
+		// Everything that is off its rest pose so far, playback can start decoding here
+		m_changed.clear();
+		for (DominoId id = 0; id < (DominoId)m_poses.size(); id++)
+		{
+			if (m_poses[id] != SQuantizedPose())
+				m_changed.emplace_back(id, m_poses[id]);
+		}
+
+		WriteFrame(chunk.data, true);
+		chunk.framesOffset = chunk.data.size();
+	}
+
+	// Sleeping pieces can't have moved since the last sample
+	m_changed.clear();
+	partition.ForEachMaterialized([this, &partition](DominoId id, IEntity& entity)
+		{
+			IPhysicalEntity* pPhysics = entity.GetPhysics();
+			pe_status_awake status;
+			if (pPhysics == nullptr || !pPhysics->GetStatus(&status) || id >= m_poses.size())
+				return;
+
+			const SQuantizedPose pose = Quantize(partition.GetRecord(id), entity.GetWorldPos(), entity.GetWorldRotation());
+			if (pose != m_poses[id])
+				m_changed.emplace_back(id, pose);
+		});
+
+	// Ascending ids keep the id deltas small
+	std::sort(m_changed.begin(), m_changed.end(), [](const std::pair<DominoId, SQuantizedPose>& a, const std::pair<DominoId, SQuantizedPose>& b)
+		{
+			return a.first < b.first;
+		});
+
+	WriteFrame(m_chunks.back().data, false);
+
+	for (const std::pair<DominoId, SQuantizedPose>& changed : m_changed)
+	{
+		m_poses[changed.first] = changed.second;
+	}
+
+	m_frameCount++;
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+
+void CSimulationReplay::WriteFrame(std::vector<uint8>& data, bool isKeyframe)
+{
+	static const SQuantizedPose rest;
+
+	WriteVarint(data, (uint32)m_changed.size());
+
+	DominoId previousId = 0;
+	for (const std::pair<DominoId, SQuantizedPose>& changed : m_changed)
+	{
+		const SQuantizedPose& reference = isKeyframe ? rest : m_poses[changed.first];
+		const SQuantizedPose& pose = changed.second;
+
+		WriteVarint(data, changed.first - previousId);
+		previousId = changed.first;
+
+		data.push_back(pose.largest);
+		for (int i = 0; i < 3; i++)
+		{
+			WriteDelta(data, (int32)pose.position[i] - (int32)reference.position[i]);
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			WriteDelta(data, (int32)pose.rotation[i] - (int32)reference.rotation[i]);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+size_t CSimulationReplay::DecodeFrame(CDominoWorldPartition& partition, const std::vector<uint8>& data, size_t offset)
+{
+	const uint32 count = ReadVarint(data, offset);
+
+	DominoId id = 0;
+	for (uint32 i = 0; i < count && offset < data.size(); i++)
+	{
+		id += ReadVarint(data, offset);
+
+		SQuantizedPose pose;
+		pose.largest = data[offset++];
+
+		const SQuantizedPose& reference = id < m_poses.size() ? m_poses[id] : pose;
+		for (int j = 0; j < 3; j++)
+		{
+			pose.position[j] = (int16)(reference.position[j] + ReadDelta(data, offset));
+		}
+		for (int j = 0; j < 3; j++)
+		{
+			pose.rotation[j] = (int16)(reference.rotation[j] + ReadDelta(data, offset));
+		}
+
+		// Pieces added after the recording have no pose in it
+		if (id >= m_poses.size())
+			continue;
+
+		m_poses[id] = pose;
+
+		const QuatT transform = Dequantize(partition.GetRecord(id), pose);
+		partition.SetPose(id, transform.t, transform.q);
+	}
+
+	return offset;
+}
+
+//----------------------------------------------------------------------------------
+
+void CSimulationReplay::Seek(CDominoWorldPartition& partition, float time)
+{
+	if (m_chunks.empty())
+		return;
+
+	const uint32 frame = min((uint32)max(time * m_sampleRate, 0.f), m_frameCount);
+
+	size_t chunkIndex = m_chunks.size() - 1;
+	while (chunkIndex > 0 && m_chunks[chunkIndex].firstFrame > frame)
+	{
+		chunkIndex--;
+	}
+
+	// Back to rest, then the keyframe brings back whatever had moved by then
+	partition.ResetToRest();
+	std::fill(m_poses.begin(), m_poses.end(), SQuantizedPose());
+
+	const SChunk& chunk = m_chunks[chunkIndex];
+	DecodeFrame(partition, chunk.data, 0);
+
+	m_playChunk = chunkIndex;
+	m_playOffset = chunk.framesOffset;
+	m_playFrame = chunk.firstFrame;
+	m_playTime = (float)m_playFrame / m_sampleRate;
+
+	Play(partition, time - m_playTime);
+}
+
+//----------------------------------------------------------------------------------
+
+bool CSimulationReplay::Play(CDominoWorldPartition& partition, float frameTime)
+{
+	if (m_playChunk >= m_chunks.size())
+		return false;
+
+	m_playTime += frameTime;
+	const uint32 targetFrame = min((uint32)(m_playTime * m_sampleRate), m_frameCount);
+
+	while (m_playFrame < targetFrame)
+	{
+		if (m_playOffset >= m_chunks[m_playChunk].data.size())
+		{
+			// The next chunk's keyframe matches the poses decoded so far, skip it
+			if (++m_playChunk >= m_chunks.size())
+				return false;
+
+			m_playOffset = m_chunks[m_playChunk].framesOffset;
+		}
+
+		m_playOffset = DecodeFrame(partition, m_chunks[m_playChunk].data, m_playOffset);
+		m_playFrame++;
+	}
+
+	return m_playFrame < m_frameCount;
+}
+
+//----------------------------------------------------------------------------------
+
+void CSimulationReplay::Clear()
+{
+	m_chunks.clear();
+	m_poses.clear();
+	m_changed.clear();
+	m_frameCount = 0;
+	m_sampleTime = 0.f;
+	m_isRecording = false;
+
+	m_playChunk = 0;
+	m_playOffset = 0;
+	m_playFrame = 0;
+	m_playTime = 0.f;
+}
+
+//----------------------------------------------------------------------------------
+
+void CSimulationReplay::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddContainer(m_chunks);
+	for (const SChunk& chunk : m_chunks)
+	{
+		pSizer->AddContainer(chunk.data);
+	}
+	pSizer->AddContainer(m_poses);
+	pSizer->AddContainer(m_changed);
+}
+
+//----------------------------------------------------------------------------------
+
+size_t CSimulationReplay::GetByteCount() const
+{
+	size_t byteCount = 0;
+	for (const SChunk& chunk : m_chunks)
+	{
+		byteCount += chunk.data.size();
+	}
+	return byteCount;
+}
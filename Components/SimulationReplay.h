@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+
+#include "DominoWorldPartition.h"
+
+////////////////////////////////////////////////////////
+// Records a simulation run as a compact pose stream and plays it back
+// Each sample only writes the pieces whose quantized pose changed, as varint
+// deltas, in chunks that open with a keyframe so playback can seek.
+// Playback moves the pieces kinematically with physics off
+////////////////////////////////////////////////////////
+
+class CSimulationReplay
+{
+public:
+	typedef CDominoWorldPartition::DominoId DominoId;
+
+	// Drops any previous recording, expects every piece at its rest pose
+	void BeginRecording(const CDominoWorldPartition& partition);
+	// Samples the awake pieces at m_sampleRate, returns false once the recording is full
+	bool Record(const CDominoWorldPartition& partition, float frameTime);
+	void EndRecording() { m_isRecording = false; }
+
+	bool IsRecording() const { return m_isRecording; }
+	bool HasRecording() const { return m_frameCount > 0; }
+
+	// Poses the pieces as they were at the given time, decoding from the closest keyframe
+	void Seek(CDominoWorldPartition& partition, float time);
+	// Advances playback, returns false once the end of the recording is reached
+	bool Play(CDominoWorldPartition& partition, float frameTime);
+
+	void Clear();
+
+	float GetDuration() const { return (float)m_frameCount / m_sampleRate; }
+	size_t GetByteCount() const;
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+	// Samples per second, playback steps at the same rate
+	float m_sampleRate = 30.f;
+	// Every chunk opens with a keyframe, 0 records a single chunk that can only be played from the start
+	uint32 m_framesPerChunk = 60;
+	// Recording stops once the stream reaches this size, a minute of a few thousand falling pieces fits
+	size_t m_maxBytes = 8 << 20;
+
+private:
+	// Pose relative to the piece's rest pose
+	struct SQuantizedPose
+	{
+		// In 1/PositionScale metres from the rest position
+		int16 position[3] = { 0, 0, 0 };
+		// The three smallest components of the rotation from the rest rotation, the largest one is implied
+		int16 rotation[3] = { 0, 0, 0 };
+		uint8 largest = 3;
+
+		bool operator==(const SQuantizedPose& other) const;
+		bool operator!=(const SQuantizedPose& other) const { return !(*this == other); }
+	};
+
+	struct SChunk
+	{
+		uint32 firstFrame = 0;
+		// Delta frames start after the keyframe
+		size_t framesOffset = 0;
+		std::vector<uint8> data;
+	};
+
+	static SQuantizedPose Quantize(const CDominoWorldPartition::SDominoRecord& record, const Vec3& position, const Quat& rotation);
+	static QuatT Dequantize(const CDominoWorldPartition::SDominoRecord& record, const SQuantizedPose& pose);
+
+	// Writes m_changed as deltas from m_poses, or from the rest pose for a keyframe
+	void WriteFrame(std::vector<uint8>& data, bool isKeyframe);
+	// Applies one frame to m_poses and to the partition, returns the offset past it
+	size_t DecodeFrame(CDominoWorldPartition& partition, const std::vector<uint8>& data, size_t offset);
+
+	std::vector<SChunk> m_chunks;
+	// Last recorded poses, or last decoded ones during playback
+	std::vector<SQuantizedPose> m_poses;
+	std::vector<std::pair<DominoId, SQuantizedPose>> m_changed;
+
+	uint32 m_frameCount = 0;
+	float m_sampleTime = 0.f;
+	bool m_isRecording = false;
+
+	size_t m_playChunk = 0;
+	size_t m_playOffset = 0;
+	uint32 m_playFrame = 0;
+	float m_playTime = 0.f;
+};
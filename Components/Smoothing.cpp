@@ -0,0 +1,64 @@
+#include "StdAfx.h"
+#include "Smoothing.h"
+
+#include <CrySystem/IConsole.h>
+
+namespace Smoothing
+{
+	//----------------------------------------------------------------------------------
+
+	// Steps both helpers from 0 towards 10 for duration seconds at fps, returns the end states
+	static void Step(float fps, float duration, float& spring, float& springVelocity, float& smoothed)
+	{
+		CCriticallyDampedSpring<float> springState(0.f);
+		smoothed = 0.f;
+
+		const float frameTime = 1.f / fps;
+		const int frames = (int)(duration * fps + .5f);
+		for (int i = 0; i < frames; i++)
+		{
+			springState.Update(10.f, 4.f, frameTime);
+			smoothed = ExpSmooth(smoothed, 10.f, 2.f, frameTime);
+		}
+
+		spring = springState.Get();
+		springVelocity = springState.GetVelocity();
+	}
+
+	//----------------------------------------------------------------------------------
+
+	bool CheckFrameRateIndependence()
+	{
+		static const float rates[] = { 30.f, 60.f, 144.f };
+		const float duration = 1.f;
+		const float tolerance = 1e-3f;
+
+		float referenceSpring, referenceVelocity, referenceSmoothed;
+		Step(rates[0], duration, referenceSpring, referenceVelocity, referenceSmoothed);
+
+		bool isPassed = true;
+		for (float fps : rates)
+		{
+			float spring, springVelocity, smoothed;
+			Step(fps, duration, spring, springVelocity, smoothed);
+
+			const bool isMatch = fabs_tpl(spring - referenceSpring) <= tolerance
+				&& fabs_tpl(springVelocity - referenceVelocity) <= tolerance
+				&& fabs_tpl(smoothed - referenceSmoothed) <= tolerance;
+			isPassed &= isMatch;
+
+			CryLogAlways("Smoothing: %3.0f fps after %.1f s, spring %.5f (velocity %.5f), exp %.5f %s",
+				fps, duration, spring, springVelocity, smoothed, isMatch ? "" : "MISMATCH");
+		}
+
+		CryLogAlways("Smoothing: Frame rate independence %s", isPassed ? "passed" : "FAILED");
+		return isPassed;
+	}
+
+	//----------------------------------------------------------------------------------
+
+	void CheckFrameRateIndependenceCommand(IConsoleCmdArgs* pArgs)
+	{
+		CheckFrameRateIndependence();
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <CryMath/Cry_Math.h>
+
+struct IConsoleCmdArgs;
+
+////////////////////////////////////////////////////////
+// Frame-rate independent smoothing helpers
+// Unlike Lerp(a, b, frameTime * k) these never overshoot, and
+// stepping a second in 30 or 144 frames lands on the same value
+////////////////////////////////////////////////////////
+
+namespace Smoothing
+{
+	// Steps both helpers over the same second at 30, 60 and 144 fps and logs whether they agree
+	bool CheckFrameRateIndependence();
+	// d_dominoCheckSmoothing
+	void CheckFrameRateIndependenceCommand(IConsoleCmdArgs* pArgs);
+
+	// Exponential approach towards target, rate is in 1/seconds
+	template<typename T>
+	inline T ExpSmooth(const T& current, const T& target, float rate, float frameTime)
+	{
+		const float t = 1.f - exp_tpl(-rate * frameTime);
+		return current + (target - current) * t;
+	}
+
+	// Critically damped spring towards a target
+	// Uses the exact solution of x'' = -w^2 x - 2w x' for a target held constant over the step
+	template<typename T>
+	class CCriticallyDampedSpring
+	{
+	public:
+
+		CCriticallyDampedSpring() = default;
+		explicit CCriticallyDampedSpring(const T& value)
+			: m_value(value)
+			, m_velocity(ZERO)
+		{
+		}
+
+		// angularFrequency is in radians per second, higher values settle faster
+		const T& Update(const T& target, float angularFrequency, float frameTime)
+		{
+			const T offset = m_value - target;
+			const float decay = exp_tpl(-angularFrequency * frameTime);
+			const T temp = (m_velocity + offset * angularFrequency) * frameTime;
+
+			m_value = target + (offset + temp) * decay;
+			m_velocity = (m_velocity - temp * angularFrequency) * decay;
+
+			return m_value;
+		}
+
+		void Reset(const T& value)
+		{
+			m_value = value;
+			m_velocity = ZERO;
+		}
+
+		const T& Get() const { return m_value; }
+		const T& GetVelocity() const { return m_velocity; }
+
+	private:
+
+		T m_value = ZERO;
+		T m_velocity = ZERO;
+	};
+}
@@ -1,6 +1,8 @@
 // Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
 #include "StdAfx.h"
 #include "SpawnPoint.h"
+#include "Player.h"
+#include "GamePlugin.h"
 
 #include <CrySchematyc/Reflection/TypeDesc.h>
 #include <CrySchematyc/Utils/EnumFlags.h>
@@ -26,3 +28,84 @@ static void RegisterSpawnPointComponent(Schematyc::IEnvRegistrar& registrar)
 }
 
 CRY_STATIC_AUTO_REGISTER_FUNCTION(&RegisterSpawnPointComponent)
+
+std::vector<CSpawnPointComponent*> CSpawnPointComponent::s_spawnPoints;
+size_t CSpawnPointComponent::s_nextSpawnPoint = 0;
+
+//----------------------------------------------------------------------------------
+
+CSpawnPointComponent::~CSpawnPointComponent()
+{
+	if (m_registryIndex >= s_spawnPoints.size())
+		return;
+
+	CSpawnPointComponent* pLast = s_spawnPoints.back();
+	s_spawnPoints[m_registryIndex] = pLast;
+	pLast->m_registryIndex = m_registryIndex;
+	s_spawnPoints.pop_back();
+}
+
+//----------------------------------------------------------------------------------
+
+void CSpawnPointComponent::Initialize()
+{
+	if (m_registryIndex < s_spawnPoints.size())
+		return;
+
+	m_registryIndex = s_spawnPoints.size();
+	s_spawnPoints.push_back(this);
+}
+
+//----------------------------------------------------------------------------------
+
+Matrix34 CSpawnPointComponent::GetSpawnPointTransform(EPolicy policy, const Vec3& position, float clearance)
+{
+	if (s_spawnPoints.empty())
+		return IDENTITY;
+
+	switch (policy)
+	{
+	case EPolicy::RoundRobin:
+	{
+		const size_t index = s_nextSpawnPoint++ % s_spawnPoints.size();
+		return s_spawnPoints[index]->GetWorldTransformMatrix();
+	}
+
+	case EPolicy::NearestFree:
+	{
+		const CSpawnPointComponent* pNearest = nullptr;
+		float nearestDistanceSq = FLT_MAX;
+
+		for (const CSpawnPointComponent* pSpawnPoint : s_spawnPoints)
+		{
+			const Vec3 spawnPosition = pSpawnPoint->GetWorldTransformMatrix().GetTranslation();
+			const float distanceSq = spawnPosition.GetSquaredDistance(position);
+			if (distanceSq < nearestDistanceSq && IsFree(spawnPosition, clearance))
+			{
+				pNearest = pSpawnPoint;
+				nearestDistanceSq = distanceSq;
+			}
+		}
+
+		// All taken, fall back to sharing the first one
+		return (pNearest != nullptr ? pNearest : s_spawnPoints.front())->GetWorldTransformMatrix();
+	}
+
+	case EPolicy::First:
+	default:
+		return s_spawnPoints.front()->GetWorldTransformMatrix();
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+bool CSpawnPointComponent::IsFree(const Vec3& position, float clearance)
+{
+	bool isFree = true;
+	CGamePlugin::GetInstance()->IterateOverPlayers([&isFree, &position, clearance](CPlayerComponent& player)
+		{
+			if (player.GetEntity()->GetWorldPos().GetSquaredDistance(position) < sqr(clearance))
+				isFree = false;
+		});
+	return isFree;
+}
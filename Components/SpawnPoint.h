@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include <CryEntitySystem/IEntitySystem.h>
 
 ////////////////////////////////////////////////////////
@@ -10,8 +12,22 @@
 class CSpawnPointComponent final : public IEntityComponent
 {
 public:
+	enum class EPolicy
+	{
+		// Always the first registered spawn point
+		First = 0,
+		// Cycles through the spawn points, one per call
+		RoundRobin,
+		// Closest spawn point to the given position with no player within the clearance radius
+		NearestFree
+	};
+
 	CSpawnPointComponent() = default;
-	virtual ~CSpawnPointComponent() = default;
+	virtual ~CSpawnPointComponent();
+
+	// IEntityComponent
+	virtual void Initialize() override;
+	// ~IEntityComponent
 
 	// Reflect type to set a unique identifier for this component
 	// and provide additional information to expose it in the sandbox
@@ -24,22 +40,20 @@ public:
 		desc.SetComponentFlags({ IEntityComponent::EFlags::Transform, IEntityComponent::EFlags::Socket, IEntityComponent::EFlags::Attach });
 	}
 	
-	static Matrix34 GetFirstSpawnPointTransform()
-	{
-		// Spawn at first default spawner
-		IEntityItPtr pEntityIterator = gEnv->pEntitySystem->GetEntityIterator();
-		pEntityIterator->MoveFirst();
-
-		while (!pEntityIterator->IsEnd())
-		{
-			IEntity *pEntity = pEntityIterator->Next();
-
-			if (CSpawnPointComponent* pSpawner = pEntity->GetComponent<CSpawnPointComponent>())
-			{
-				return pSpawner->GetWorldTransformMatrix();
-			}
-		}
-		
-		return IDENTITY;
-	}
+	static Matrix34 GetFirstSpawnPointTransform() { return GetSpawnPointTransform(EPolicy::First); }
+
+	// Picks from the spawn points registered on Initialize, no entity scan
+	// Returns identity if the level has no spawn point
+	static Matrix34 GetSpawnPointTransform(EPolicy policy, const Vec3& position = ZERO, float clearance = 2.f);
+
+	static size_t GetSpawnPointCount() { return s_spawnPoints.size(); }
+
+private:
+	static bool IsFree(const Vec3& position, float clearance);
+
+	// Every initialized spawn point, removal swaps the last one into the freed slot
+	static std::vector<CSpawnPointComponent*> s_spawnPoints;
+	static size_t s_nextSpawnPoint;
+
+	size_t m_registryIndex = ~size_t(0);
 };
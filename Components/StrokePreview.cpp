@@ -0,0 +1,139 @@
+#include "StdAfx.h"
+#include "StrokePreview.h"
+
+#include <Cry3DEngine/IMaterial.h>
+
+//----------------------------------------------------------------------------------
+
+CStrokePreview::~CStrokePreview()
+{
+	Reset();
+}
+
+//----------------------------------------------------------------------------------
+
+void CStrokePreview::LoadSources()
+{
+	if (m_pBody != nullptr)
+		return;
+
+	// Same mesh as the pieces, prefetched at startup
+	m_pBody = gEnv->p3DEngine->LoadStatObj(DominoAssets::BodyGeometry);
+
+	if (IMaterial* pBodyMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial(DominoAssets::BodyMaterial))
+	{
+		m_pGhostMaterial = gEnv->p3DEngine->GetMaterialManager()->CloneMaterial(pBodyMaterial);
+		float opacity = m_opacity;
+		m_pGhostMaterial->SetGetMaterialParamFloat("opacity", opacity, false);
+	}
+}
+
+//----------------------------------------------------------------------------------
+
+Matrix34 CStrokePreview::MakeTransform(const Vec3& position, const Quat& rotation, EDominoKind kind)
+{
+	return Matrix34::Create(Vec3(CDominoKindRegistry::Get(kind).scale), rotation, position);
+}
+
+//----------------------------------------------------------------------------------
+
+void CStrokePreview::SetCursor(const Vec3& position, const Quat& rotation, EDominoKind kind)
+{
+	m_cursor = QuatT(rotation, position);
+	m_cursorTransform = MakeTransform(position, rotation, kind);
+	m_hasCursor = true;
+}
+
+//----------------------------------------------------------------------------------
+
+void CStrokePreview::HideCursor()
+{
+	m_hasCursor = false;
+}
+
+//----------------------------------------------------------------------------------
+
+void CStrokePreview::Add(const Vec3& position, const Quat& rotation, EDominoKind kind)
+{
+	m_pieces.push_back({ MakeTransform(position, rotation, kind) });
+}
+
+//----------------------------------------------------------------------------------
+
+void CStrokePreview::Clear()
+{
+	m_pieces.clear();
+	m_hasCursor = false;
+	m_placedCount = 0;
+	Update();
+}
+
+//----------------------------------------------------------------------------------
+
+void CStrokePreview::Place(size_t index, const Matrix34& transform)
+{
+	static_cast<IBrush*>(m_nodes[index])->SetMatrix(transform);
+}
+
+//----------------------------------------------------------------------------------
+
+void CStrokePreview::Update()
+{
+	const size_t needed = m_pieces.size() + (m_hasCursor ? 1 : 0);
+	if (needed > 0)
+		LoadSources();
+
+	while (m_nodes.size() < needed)
+	{
+		IBrush* pBrush = static_cast<IBrush*>(gEnv->p3DEngine->CreateRenderNode(eERType_Brush));
+		pBrush->SetEntityStatObj(m_pBody, nullptr);
+		pBrush->SetMaterial(m_pGhostMaterial);
+		pBrush->SetRndFlags(ERF_CASTSHADOWMAPS | ERF_HAS_CASTSHADOWMAPS, false);
+		m_nodes.push_back(pBrush);
+	}
+
+	// Pieces never move once added, only the new ones and the cursor are touched
+	for (size_t i = m_placedCount; i < m_pieces.size(); i++)
+	{
+		Place(i, m_pieces[i].transform);
+	}
+	m_placedCount = m_pieces.size();
+
+	if (m_hasCursor)
+		Place(m_pieces.size(), m_cursorTransform);
+
+	for (size_t i = needed; i < m_visibleCount; i++)
+	{
+		gEnv->p3DEngine->UnRegisterEntityDirect(m_nodes[i]);
+	}
+	for (size_t i = m_visibleCount; i < needed; i++)
+	{
+		gEnv->p3DEngine->RegisterEntity(m_nodes[i]);
+	}
+	m_visibleCount = needed;
+}
+
+//----------------------------------------------------------------------------------
+
+void CStrokePreview::Reset()
+{
+	if (gEnv->p3DEngine == nullptr)
+		m_nodes.clear();
+
+	for (size_t i = 0; i < m_nodes.size(); i++)
+	{
+		if (i < m_visibleCount)
+			gEnv->p3DEngine->UnRegisterEntityDirect(m_nodes[i]);
+
+		gEnv->p3DEngine->DeleteRenderNode(m_nodes[i]);
+	}
+
+	m_nodes.clear();
+	m_pieces.clear();
+	m_visibleCount = 0;
+	m_placedCount = 0;
+	m_hasCursor = false;
+
+	m_pBody = nullptr;
+	m_pGhostMaterial = nullptr;
+}
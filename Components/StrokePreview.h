@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include <Cry3DEngine/I3DEngine.h>
+#include <Cry3DEngine/IStatObj.h>
+
+#include "DominoKind.h"
+
+////////////////////////////////////////////////////////
+// Render-only ghosts of the stroke being drawn
+// Every pending piece is a bare brush render node sharing one body mesh and one
+// translucent material, so the renderer instances them. No entity, no physics;
+// the pieces only become dominoes when the stroke is committed
+////////////////////////////////////////////////////////
+
+class CStrokePreview
+{
+public:
+	~CStrokePreview();
+
+	// The next piece the stroke would place, follows the cursor until it is added
+	void SetCursor(const Vec3& position, const Quat& rotation, EDominoKind kind);
+	void HideCursor();
+	bool HasCursor() const { return m_hasCursor; }
+	const QuatT& GetCursor() const { return m_cursor; }
+
+	void Add(const Vec3& position, const Quat& rotation, EDominoKind kind);
+	// Hides every ghost, the render nodes are kept for the next stroke
+	void Clear();
+
+	// Moves the render nodes onto the pending pieces, call once per frame
+	void Update();
+
+	size_t GetCount() const { return m_pieces.size(); }
+	// Releases the render nodes and the ghost material
+	void Reset();
+
+	// Opacity of the ghost material
+	float m_opacity = .35f;
+
+private:
+	struct SPiece
+	{
+		Matrix34 transform;
+	};
+
+	static Matrix34 MakeTransform(const Vec3& position, const Quat& rotation, EDominoKind kind);
+
+	void LoadSources();
+	void Place(size_t index, const Matrix34& transform);
+
+	std::vector<SPiece> m_pieces;
+	QuatT m_cursor = QuatT(IDENTITY);
+	Matrix34 m_cursorTransform = Matrix34(IDENTITY);
+	bool m_hasCursor = false;
+
+	_smart_ptr<IStatObj> m_pBody;
+	_smart_ptr<IMaterial> m_pGhostMaterial;
+
+	std::vector<IRenderNode*> m_nodes;
+	// Nodes currently registered with the 3D engine
+	size_t m_visibleCount = 0;
+	// Pieces already moved onto their node, only new ones are touched
+	size_t m_placedCount = 0;
+};
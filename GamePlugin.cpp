@@ -3,6 +3,10 @@
 #include "GamePlugin.h"
 
 #include "Components/Player.h"
+#include "Components/DominoCVars.h"
+#include "Components/DominoAssetPrefetch.h"
+#include "Components/DominoCollisions.h"
+#include "Components/DominoPhysics.h"
 
 #include <CrySchematyc/Env/IEnvRegistry.h>
 #include <CrySchematyc/Env/EnvPackage.h>
@@ -24,6 +28,10 @@ CGamePlugin::~CGamePlugin()
 
 	gEnv->pSystem->GetISystemEventDispatcher()->RemoveListener(this);
 
+	CDominoAssetPrefetch::Get().Reset();
+	CDominoCollisions::Get().Unregister();
+	SDominoCVars::Get().Unregister();
+
 	if (gEnv->pSchematyc)
 	{
 		gEnv->pSchematyc->GetEnvRegistry().DeregisterPackage(CGamePlugin::GetCID());
@@ -34,10 +42,20 @@ bool CGamePlugin::Initialize(SSystemGlobalEnvironment& env, const SSystemInitPar
 {
 	// Register for engine system events, in our case we need ESYSTEM_EVENT_GAME_POST_INIT to load the map
 	gEnv->pSystem->GetISystemEventDispatcher()->RegisterListener(this, "CGamePlugin");
+
+	SDominoCVars::Get().Register();
+
+	// Drives the domino asset prefetch
+	EnableUpdate(EUpdateStep::MainUpdate, true);
 	
 	return true;
 }
 
+void CGamePlugin::MainUpdate(float frameTime)
+{
+	CDominoAssetPrefetch::Get().Update();
+}
+
 void CGamePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lparam)
 {
 	switch (event)
@@ -48,6 +66,13 @@ void CGamePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lp
 			// Listen for client connection events, in order to create the local player
 			gEnv->pGameFramework->AddNetworkedClientListener(*this);
 
+			// Start streaming the domino assets while the map loads
+			CDominoAssetPrefetch::Get().Start();
+
+			// One listener gathers the contacts of every domino
+			CDominoCollisions::Get().Register();
+			DominoPhysics::ApplySurfaceParameters();
+
 			// Don't need to load the map in editor
 			if (!gEnv->IsEditor())
 			{
@@ -81,6 +106,13 @@ void CGamePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lp
 		}
 		break;
 		
+		// Covers levels opened in the editor, does nothing if the prefetch already ran
+		case ESYSTEM_EVENT_LEVEL_LOAD_START:
+		{
+			CDominoAssetPrefetch::Get().Start();
+		}
+		break;
+
 		case ESYSTEM_EVENT_LEVEL_UNLOAD:
 		{
 			m_players.clear();